@@ -119,7 +119,7 @@ int main()
         // -- -- -- -- -- - //
     */
 
-    Matrix moment_of_inertia = {
+    constexpr Matrix moment_of_inertia = {
         0.0067, 0.0000, 0.0000,
         0.0003, 0.0333, 0.0000,
         0.0000, 0.0000, 0.0333
@@ -168,7 +168,7 @@ int main()
                    x, y, z, angular_velocity, angular_acceleration,
                    bar_m, hyst_vol, hyst_nd,
                    num_x_hyst, num_y_hyst, num_z_hyst,
-                   H_c, B_r, B_s, q_0, p);
+                   FlatleyLoop{H_c, B_r, B_s, q_0, p});
     cout << "Initialised Satellite..." << endl
                                        << endl;
     // Exporting parameters
@@ -0,0 +1,50 @@
+#include <iostream>
+#include <string>
+#include "Numerics.h"
+#include "Simulation.h"
+using namespace std;
+
+// Converts an STK CSV export into the binary series format read by
+// SampleDataVector::mapBinary() and readMagFile().
+//
+// Usage:
+//   ./csv_to_bin.out input.csv output.bin [time_col x_col y_col z_col]
+//
+// Column names default to the STK magnetic field export headers.
+// Values are stored unscaled (as in the CSV).
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3 && argc != 7){
+        cerr << "Usage: " << argv[0]
+             << " input.csv output.bin [time_col x_col y_col z_col]"
+             << endl;
+        return 1;
+    }
+
+    string inputFile  = argv[1];
+    string outputFile = argv[2];
+
+    string timeColumn = "\"Time (UTCG)\"";
+    string colX = "\"x (nT)\"";
+    string colY = "\"y (nT)\"";
+    string colZ = "\"z (nT)\"";
+    if (argc == 7){
+        timeColumn = argv[3];
+        colX = argv[4];
+        colY = argv[5];
+        colZ = argv[6];
+    }
+
+    cout << "Reading " << inputFile << "..." << endl;
+    SampleDataVector data(inputFile, timeColumn, {colX, colY, colZ});
+    if (!data.isSorted())
+        data.sort();
+
+    cout << "Writing " << data.size() << " samples to "
+         << outputFile << "..." << endl;
+    data.writeBinary(outputFile);
+
+    cout << "Done." << endl;
+    return 0;
+}
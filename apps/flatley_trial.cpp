@@ -2,6 +2,8 @@
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
+#include <vector>
 #include "Flatley.h"
 #include "Vector.h"
 #include "Simulation.h"
@@ -42,6 +44,13 @@ int main()
         H_c, B_r, B_s, q_0, p
     );
 
+    // The same rod following the differential model
+    Flatley diffRod(
+        0, 0, 0, 0, 0, {0,0,1},
+        H_c, B_r, B_s, q_0, p
+    );
+    diffRod.setForm(Flatley::Form::Differential);
+
     /* NOTE:
         // -- -- -- -- -- //
         // MAGNETIC FIELD //
@@ -57,7 +66,14 @@ int main()
     Vector x = {1, 0, 0};
     bool slope = 0;
 
-    file << "S.No,H(A/m),B(T),slope" << endl;
+    file << "S.No,H(A/m),B(T),slope,B_diff(T),substeps" << endl;
+
+    // Substeps of the differential rod, and its B each time H rises
+    // through 0 (the same point of successive cycles)
+    long totalSubsteps = 0;
+    int maxSubsteps = 0, idleCalls = 0, singleCalls = 0;
+    vector<double> crossings;
+    double hLast = 0, bDiffLast = 0;
 
     for (int counter = 0; counter < num_iterations; counter++){
 
@@ -66,16 +82,50 @@ int main()
         B = rod.getMagField();
         slope = rod.getSlopeSign();
 
+        double bDiff = diffRod.calcMagField(timestep, H, {1, 0, 0});
+        int substeps = diffRod.getSubsteps();
+        totalSubsteps += substeps;
+        maxSubsteps = max(maxSubsteps, substeps);
+        idleCalls += substeps == 0;
+        singleCalls += substeps == 1;
+
+        double h = H*x;
+        if (hLast < 0 && h >= 0)
+            crossings.push_back(bDiffLast + (bDiff - bDiffLast)
+                                            * (-hLast) / (h - hLast));
+        hLast = h;
+        bDiffLast = bDiff;
+
         file << counter+1 << ","
              << H*x << "," 
              << B*x << ","
-             << slope << endl;
+             << slope << ","
+             << bDiff << ","
+             << substeps << endl;
 
         ostringstream output;
         output << progressBar(counter, num_iterations, "Simulation Progress");
         cout << output.str();
     }
 
+    // Loop closure: how far B at the same point moves from one cycle to
+    // the next, once the first cycles have settled onto the loop
+    double closure = 0;
+    for (size_t i = 2; i < crossings.size(); i++)
+        closure = max(closure, fabs(crossings[i] - crossings[i - 1]));
+
+    cout << endl << endl
+         << "Differential model (error tolerance "
+         << FlatleyDifferential::errorTolerance << " B_s per substep)"
+         << endl
+         << "  substeps per call : "
+         << static_cast<double>(totalSubsteps) / num_iterations
+         << " mean, " << maxSubsteps << " max" << endl
+         << "  calls with 0 / 1  : " << idleCalls << " / " << singleCalls
+         << " of " << num_iterations << endl
+         << "  loop closure      : " << closure << " T over "
+         << crossings.size() << " cycles" << endl;
+
     /* NOTE:
         // -- -- -- -- -- -- -- -- -- -- -- -- //
         // READING DATA n SIMULATING SATELLITE //
@@ -82,12 +82,22 @@ int main()
 
     // Inputting data
     string inputmagfile = "../data/csv/igrf-icrf_55_10d-1s.csv";
+    string igrfFile = "../data/igrf14coeffs.txt";   // IGRF table, if any
 
     // Setting simulation time details
     DateTime start_time("01 Oct 2025 07:00:00.000");
     DateTime stop_time("01 Oct 2025 13:59:59.000");
     double timestep = 0.01;        // in seconds
 
+    // Orbit used (field computed along it) if there is no field export:
+    // 500 km sun-synchronous (97.4 deg, where the J2 node drift is the
+    // Sun's 0.9856 deg/day), placed like the position export: ascending
+    // node at RA -35.2 deg (06:30:02) and 114 deg past it by start_time.
+    // The export's frame is not inertial, so its state is not propagated
+    OrbitPropagator orbit = OrbitPropagator::circular(
+        500.0, 97.4 * M_PI / 180.0, start_time,
+        -35.2 * M_PI / 180.0, 114.0 * M_PI / 180.0);
+
 
     /* NOTE:
         // -- -- -- -- -- --- //
@@ -126,7 +136,7 @@ int main()
         // -- -- -- -- -- - //
     */
 
-    Matrix moment_of_inertia = {
+    constexpr Matrix moment_of_inertia = {
         0.0067, 0.0000, 0.0000,
         0.0003, 0.0333, 0.0000,
         0.0000, 0.0000, 0.0333
@@ -158,8 +168,14 @@ int main()
     // venv_activate();
 
     // Reading and storing magetic fields
+    bool fieldExport = filesystem::exists(inputmagfile);
     cout << "Reading Magnetic Field Data..." << endl;
-    SampleDataVector magData = readMagFile(inputmagfile);
+    SampleDataVector magData;
+    if (fieldExport)
+        magData = readMagFile(inputmagfile, start_time, stop_time,
+                              timestep, "../data/cache");
+    OrbitField orbitData = orbitField(
+        orbit, filesystem::exists(igrfFile) ? igrfFile : "");
     cout << "Read magnetic field data." << endl
                                         << endl;
 
@@ -169,7 +185,7 @@ int main()
                    x, y, z, angular_velocity, angular_acceleration,
                    bar_m, hyst_vol, hyst_nd,
                    num_x_hyst, num_y_hyst, num_z_hyst,
-                   H_c, B_r, B_s, q_0, p);
+                   FlatleyLoop{H_c, B_r, B_s, q_0, p});
     cout << "Initialised Satellite..." << endl
                                        << endl;
     // Exporting parameters
@@ -177,8 +193,12 @@ int main()
 
     // Simulating and storing data
     // simulate(ahan, magData, start_time, stop_time, timestep, outputCSVFile);
-    simulate(ahan, magData, start_time, stop_time, timestep, outputCSVFile,
-             IntegratorType::Euler, false);
+    if (fieldExport)
+        simulate(ahan, magData, start_time, stop_time, timestep,
+                 outputCSVFile, IntegratorType::Euler, false);
+    else
+        simulate(ahan, orbitData, start_time, stop_time, timestep,
+                 outputCSVFile, IntegratorType::Euler, false);
 
     // Plotting data
     command("python3 ../utils/plot.py " + outputCSVFile);
@@ -0,0 +1,62 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <string>
+#include <iostream>
+#include <iomanip>
+
+// Small helpers shared by the executables in benchmarks/. Each benchmark
+// is a plain program (no framework) so it builds with the rest of the
+// tree and can be run straight from bin/.
+
+namespace bench
+{
+
+// Wall clock stopwatch started on construction
+class Timer
+{
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    double seconds() const
+    {
+        return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+    }
+
+    void reset()
+    {
+        start = std::chrono::steady_clock::now();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Keeps the optimiser from discarding a computed value
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Prints one aligned result row: label, time per iteration, rate
+inline void report(const std::string& label,
+                   double seconds,
+                   double iterations,
+                   const std::string& unit = "iter")
+{
+    std::cout << std::left << std::setw(36) << label
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << seconds / iterations * 1e9 << " ns/"
+              << unit
+              << std::setw(16) << std::setprecision(0)
+              << iterations / seconds << " " << unit << "/s"
+              << std::endl;
+}
+
+} // namespace bench
+
+#endif // BENCH_H
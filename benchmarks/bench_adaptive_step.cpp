@@ -0,0 +1,210 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "OrbitPropagator.h"
+#include "Satellite.h"
+#include "Simulation.h"
+using namespace std;
+
+// The DormandPrince45 integrator against tolerance. main.cpp's satellite
+// (PMAC rods, tumbling at 0.17 rad/s per axis) runs for ten minutes in
+// the field along a propagated 500 km orbit, writing a row every second
+// as simulate() does; the rows are compared with fixed step RK4 at
+// 1/1280 s. Per tolerance: steps kept and rejected, derivative
+// evaluations, the largest error over the rows (angular velocity and
+// attitude) and the wall time. Fixed step RK4 at simulate()'s usual
+// steps is listed for comparison, at four evaluations per step.
+//
+// As in bench_integrator_order, the first runs keep every rod on one
+// branch so that the torque is smooth; on the inverse tangent model the
+// controller has to find each branch change with short steps.
+//
+// Last, an hour of the same satellite from a range of rates with the
+// default StepControl: the steps lengthen as the rate falls.
+
+struct Row
+{
+    Quaternion attitude;
+    Vector angularVelocity;
+};
+
+struct Run
+{
+    vector<Row> rows;
+    StepStatistics stats;
+    double seconds;     // wall time of the run
+};
+
+template <typename Model>
+BasicSatellite<Model> satelliteFor(const typename Model::Loop& loop,
+                                   double branchTolerance,
+                                   double rate = 0.17)
+{
+    BasicSatellite<Model> satellite(
+        Matrix{0.0067, 0.0000, 0.0000,
+               0.0003, 0.0333, 0.0000,
+               0.0000, 0.0000, 0.0333},
+        {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+        {rate, rate, rate}, {0.00001, 0, 0},
+        12.0, 1.4e-8, 0, 3, 3, 0, loop);
+    satellite.setHystTolerance(branchTolerance);
+    return satellite;
+}
+
+// Attitude from the body axes of a row
+static Quaternion attitudeOf(const SimulationContext& ctx)
+{
+    return Quaternion::fromAxes(ctx.orientation[0], ctx.orientation[1],
+                                ctx.orientation[2]);
+}
+
+template <typename Model>
+Run adaptive(const typename Model::Loop& loop, const OrbitField& field,
+             const DateTime& start, double duration, double interval,
+             const StepControl& control, double branchTolerance)
+{
+    BasicSatellite<Model> satellite = satelliteFor<Model>(loop,
+                                                          branchTolerance);
+    SimulationContext ctx(start);
+    Run run;
+
+    bench::Timer timer;
+    run.stats = integrateAdaptive(
+        satellite, field, ctx, start + duration, interval, control,
+        [&](const SimulationContext& row){
+            run.rows.push_back({attitudeOf(row), row.angularVelocity});
+        });
+    run.seconds = timer.seconds();
+    return run;
+}
+
+// Fixed step RK4 from the start, a row every interval (a multiple of dt)
+template <typename Model>
+Run fixed(const typename Model::Loop& loop, const OrbitField& field,
+          const DateTime& start, double duration, double interval,
+          double dt, double branchTolerance)
+{
+    BasicSatellite<Model> satellite = satelliteFor<Model>(loop,
+                                                          branchTolerance);
+    SimulationContext ctx(start);
+    Run run;
+    long steps = lround(duration / dt);
+    long every = lround(interval / dt);
+
+    bench::Timer timer;
+    run.rows.push_back({satellite.getAttitude(),
+                        satellite.getAngularVelocity()});
+    for (long i = 0; i < steps; i++){
+        integrateStep(satellite, field, ctx, dt,
+                      IntegratorType::RungeKutta4);
+        ctx.time = start + (i + 1) * dt;
+        if ((i + 1) % every == 0 && i + 1 < steps)
+            run.rows.push_back({satellite.getAttitude(),
+                                satellite.getAngularVelocity()});
+    }
+    run.seconds = timer.seconds();
+    run.stats.accepted = steps;
+    run.stats.evaluations = 4 * steps;
+    run.stats.smallest = run.stats.largest = dt;
+    return run;
+}
+
+// Angle between two attitudes (rad), as bench_integrator_order
+static double angleBetween(const Quaternion& a, const Quaternion& b)
+{
+    Quaternion d = a.conjugate() * b;
+    double s = sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+    return 2 * atan2(s, fabs(d.w));
+}
+
+static void report(const string& label, const Run& run, const Run& reference)
+{
+    double dw = 0, angle = 0;
+    for (size_t i = 0; i < run.rows.size() && i < reference.rows.size(); i++){
+        dw = max(dw, (run.rows[i].angularVelocity
+                      - reference.rows[i].angularVelocity).magnitude());
+        angle = max(angle, angleBetween(run.rows[i].attitude,
+                                        reference.rows[i].attitude));
+    }
+    cout << "  " << left << setw(14) << label << right << setw(8)
+         << run.stats.accepted << setw(8) << run.stats.rejected << setw(9)
+         << run.stats.evaluations << scientific << setprecision(2)
+         << setw(12) << dw << setw(12) << angle << fixed << setprecision(3)
+         << setw(10) << run.seconds * 1e3 << endl;
+}
+
+template <typename Model>
+void againstTolerance(const string& label, const typename Model::Loop& loop,
+                      const OrbitField& field, const DateTime& start,
+                      double duration, double branchTolerance = 0)
+{
+    const double interval = 1;
+    Run reference = fixed<Model>(loop, field, start, duration, interval,
+                                 1.0 / 1280, branchTolerance);
+
+    cout << endl << label << ", " << fixed << setprecision(0) << duration
+         << " s, a row every " << interval << " s" << endl
+         << "  run               kept  reject    evals    max |dw|"
+         << "   max angle   wall (ms)" << endl;
+
+    for (double tolerance : {1e-4, 1e-6, 1e-8, 1e-10}){
+        StepControl control;
+        control.relTol = tolerance;
+        control.absTol = tolerance * 1e-2;
+        Run run = adaptive<Model>(loop, field, start, duration, interval,
+                                  control, branchTolerance);
+        ostringstream name;
+        name << "DP45 " << scientific << setprecision(0) << tolerance;
+        report(name.str(), run, reference);
+    }
+    for (double dt : {0.1, 0.01}){
+        Run run = fixed<Model>(loop, field, start, duration, interval, dt,
+                               branchTolerance);
+        ostringstream name;
+        name << "RK4 " << dt << " s";
+        report(name.str(), run, reference);
+    }
+}
+
+// An hour from each rate (rad/s per axis)
+void againstRate(const OrbitField& field, const DateTime& start)
+{
+    const FlatleyLoop pmac = {1.59154, 0.35, 0.73, 0, 2};
+    StepControl control;
+
+    cout << endl << "An hour per rate, default StepControl, a row every"
+         << " 10 s" << endl
+         << "  rate (rad/s)     kept  reject  mean step (s)  longest (s)"
+         << endl;
+    for (double rate : {0.17, 0.05, 0.01, 0.002, 0.0005}){
+        Satellite satellite = satelliteFor<FlatleyAtan>(pmac, 0, rate);
+        SimulationContext ctx(start);
+        StepStatistics stats = integrateAdaptive(
+            satellite, field, ctx, start + 3600.0, 10, control,
+            [](const SimulationContext&){});
+        cout << "  " << setw(12) << setprecision(4) << rate << setw(9)
+             << stats.accepted << setw(8) << stats.rejected
+             << setprecision(3) << setw(15) << 3600.0 / stats.accepted
+             << setw(13) << stats.largest << endl;
+    }
+}
+
+int main()
+{
+    DateTime start("01 Oct 2025 07:00:00.000");
+    OrbitField field = orbitField(
+        OrbitPropagator::circular(500.0, 98.0 * M_PI / 180.0, start));
+    const double duration = 600;
+
+    const FlatleyLoop pmac = {1.59154, 0.35, 0.73, 0, 2};
+    againstTolerance<FlatleyAtan>("Flatley (one branch, smooth torque)",
+                                  pmac, field, start, duration, 1e9);
+    againstTolerance<FlatleyAtan>(FlatleyAtan::name, pmac, field, start,
+                                  duration);
+    againstRate(field, start);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "Bench.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "DateTime.h"
+#include "Numerics.h"
+#include "Satellite.h"
+#include "Simulation.h"
+using namespace std;
+
+// Counts heap allocations made while stepping the physics. Vector and
+// Matrix are inline value types, so a step of advancePhysicsStep is
+// expected to perform no allocation at all; the program exits non-zero
+// if it does.
+
+namespace
+{
+    std::atomic<size_t> allocationCount{0};
+}
+
+void* operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+int main()
+{
+    const int numSteps = 1000000;
+    const double timestep = 0.01;
+
+    // Synthetic field covering the run with one sample per second
+    DateTime startTime("01 Oct 2025 07:00:00.000");
+    SampleDataVector magData;
+    for (int i = -10; i < numSteps * timestep + 10; i++){
+        Vector B = {20 * sin(0.001 * i), 15 * cos(0.001 * i), 5};
+        magData.addSample(startTime + i, B);
+    }
+    magData.sort();
+
+    Matrix moment_of_inertia = {
+        0.0067, 0.0000, 0.0000,
+        0.0003, 0.0333, 0.0000,
+        0.0000, 0.0000, 0.0333
+    };
+    Satellite satellite(moment_of_inertia,
+                        {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+                        {0.17, 0.17, 0.17}, {0.00001, 0, 0},
+                        12.0, 1.4e-8, 0,
+                        3, 3, 0,
+                        FlatleyLoop{1.59154, 0.35, 0.73, 0, 2});
+
+    SimulationContext ctx(startTime);
+    ctx.orientation = satellite.getOrientation();
+
+    // Warm up once so any lazily initialised state is excluded
+    advancePhysicsStep(satellite, magData, ctx, timestep);
+    ctx.time = ctx.time + timestep;
+
+    size_t before = allocationCount.load();
+    bench::Timer timer;
+    for (int i = 0; i < numSteps; i++){
+        advancePhysicsStep(satellite, magData, ctx, timestep);
+        ctx.time = ctx.time + timestep;
+    }
+    double elapsed = timer.seconds();
+    size_t allocations = allocationCount.load() - before;
+
+    bench::report("advancePhysicsStep", elapsed, numSteps, "step");
+    cout << "Heap allocations    : " << allocations << endl
+         << "Allocations / step  : "
+         << static_cast<double>(allocations) / numSteps << endl;
+
+    return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "Numerics.h"
+using namespace std;
+
+// Batch SampleDataVector interpolation against a loop of single-query
+// calls, for batch sizes 4 .. 1M. Query times are sorted and spread
+// over the whole series; every configuration runs ~4M queries in total.
+// Also checks that both paths return bit-identical results.
+//
+// Usage: ./bench_batch_interpolate.out [file.csv time_col x_col y_col z_col]
+// Defaults to the position export in data/csv (run from bin/).
+
+int main(int argc, char* argv[])
+{
+    string csvFile = "../data/csv/position-eci_251001-1y-10s.csv";
+    string timeColumn = "Time (UTCG)";
+    string colX = "Position (x)";
+    string colY = "Position (y)";
+    string colZ = "Position (z)";
+    if (argc == 6){
+        csvFile = argv[1];
+        timeColumn = argv[2];
+        colX = argv[3];
+        colY = argv[4];
+        colZ = argv[5];
+    }
+
+    SampleDataVector direct(csvFile, timeColumn, {colX, colY, colZ});
+    direct.sort();
+    SampleDataVector table = direct;
+    table.buildInterpolant();
+
+    DateTime first = direct.timeAt(0);
+    double span = direct.timeAt(direct.size() - 1) - first;
+
+    const size_t total = 1 << 22;
+    mt19937 rng(7);
+    size_t mismatches = 0;
+
+    struct Mode
+    {
+        const char* name;
+        const SampleDataVector* data;
+        bool linear;
+    };
+    const Mode modes[] = {
+        {"linear",               &direct, true},
+        {"lagrange",             &direct, false},
+        {"lagrange interpolant", &table,  false},
+    };
+
+    for (const Mode& mode : modes){
+        cout << "-- " << mode.name << endl;
+
+        for (size_t batch = 4; batch <= (1u << 20); batch *= 4){
+            uniform_real_distribution<double> offset(0.0, span);
+            vector<DateTime> times(batch);
+            for (DateTime& t : times)
+                t = first + offset(rng);
+            sort(times.begin(), times.end());
+
+            vector<double> x(batch), y(batch), z(batch);
+            vector<double> bx(batch), by(batch), bz(batch);
+            size_t repeats = max<size_t>(1, total / batch);
+
+            bench::Timer timer;
+            for (size_t r = 0; r < repeats; ++r){
+                for (size_t k = 0; k < batch; ++k){
+                    Vector v = mode.linear
+                             ? mode.data->linearInterpolate(times[k])
+                             : mode.data->lagrangeInterpolate(times[k]);
+                    x[k] = v[0];
+                    y[k] = v[1];
+                    z[k] = v[2];
+                }
+                bench::doNotOptimize(x[0]);
+            }
+            double scalar = timer.seconds();
+
+            timer.reset();
+            for (size_t r = 0; r < repeats; ++r){
+                if (mode.linear)
+                    mode.data->linearInterpolate(times.data(), batch,
+                                                 bx.data(), by.data(),
+                                                 bz.data());
+                else
+                    mode.data->lagrangeInterpolate(times.data(), batch,
+                                                   bx.data(), by.data(),
+                                                   bz.data());
+                bench::doNotOptimize(bx[0]);
+            }
+            double batched = timer.seconds();
+
+            for (size_t k = 0; k < batch; ++k)
+                if (x[k] != bx[k] || y[k] != by[k] || z[k] != bz[k])
+                    ++mismatches;
+
+            double queries = static_cast<double>(batch) * repeats;
+            string size = to_string(batch);
+            bench::report("  scalar, n = " + size, scalar, queries, "query");
+            bench::report("  batch,  n = " + size, batched, queries,
+                          "query");
+        }
+    }
+
+    cout << "Mismatches           : " << mismatches << endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include "Bench.h"
+#include "Numerics.h"
+using namespace std;
+
+// Startup cost of a SampleDataVector: parsing the STK CSV against
+// mapping the equivalent binary series file, plus one interpolation
+// sweep over each to show the mapped data is read in place.
+//
+// Usage: ./bench_binary_load.out [file.csv time_col x_col y_col z_col]
+// Defaults to the position export in data/csv (run from bin/).
+
+int main(int argc, char* argv[])
+{
+    string csvFile = "../data/csv/position-eci_251001-1y-10s.csv";
+    string timeColumn = "Time (UTCG)";
+    string colX = "Position (x)";
+    string colY = "Position (y)";
+    string colZ = "Position (z)";
+    if (argc == 6){
+        csvFile = argv[1];
+        timeColumn = argv[2];
+        colX = argv[3];
+        colY = argv[4];
+        colZ = argv[5];
+    }
+
+    string binFile = (filesystem::temp_directory_path()
+                      / "bench_binary_load.bin").string();
+
+    bench::Timer timer;
+    SampleDataVector csvData(csvFile, timeColumn, {colX, colY, colZ});
+    double csvSeconds = timer.seconds();
+
+    csvData.writeBinary(binFile);
+
+    timer.reset();
+    SampleDataVector binData = SampleDataVector::mapBinary(binFile);
+    double mapSeconds = timer.seconds();
+
+    size_t n = csvData.size();
+    cout << "Samples              : " << n << endl;
+    bench::report("load CSV", csvSeconds, n, "row");
+    bench::report("map binary", mapSeconds, n, "row");
+    cout << "Startup speed-up     : " << csvSeconds / mapSeconds << "x"
+         << endl;
+    cout << "Uniform grid         : "
+         << (csvData.isUniform() ? "yes" : "no") << " (mapped: "
+         << (binData.isUniform() ? "yes" : "no") << ")" << endl;
+
+    // Query every sample interval midpoint through both copies
+    double maxDiff = 0;
+    double csvSweep = 0, binSweep = 0;
+    for (size_t i = 1; i + 3 < n; i++){
+        DateTime t = csvData.timeAt(i) + 0.5 * (csvData.timeAt(i + 1)
+                                                - csvData.timeAt(i));
+        timer.reset();
+        Vector a = csvData.lagrangeInterpolate(t);
+        csvSweep += timer.seconds();
+        timer.reset();
+        Vector b = binData.lagrangeInterpolate(t);
+        binSweep += timer.seconds();
+        maxDiff = max(maxDiff, (a - b).magnitude());
+    }
+    bench::report("interpolate (CSV, owned)", csvSweep, n, "query");
+    bench::report("interpolate (mapped)", binSweep, n, "query");
+    cout << "Max difference       : " << maxDiff << endl;
+
+    filesystem::remove(binFile);
+    return maxDiff == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "CsvReader.h"
+#include "DateTime.h"
+#include "Vector.h"
+using namespace std;
+
+// Rows per second ingesting an STK CSV export: the previous
+// getline/stringstream/stod loop against readCsvSeries() on one thread
+// and on every hardware thread.
+//
+// Usage: ./bench_csv_ingest.out [file.csv time_col x_col y_col z_col]
+// Defaults to the position export in data/csv (run from bin/).
+
+// The loop SampleDataVector used before readCsvSeries
+static size_t legacyRead(const string& filename, const string& timeColumn,
+                         const vector<string>& valueColumns)
+{
+    ifstream file(filename);
+    string line, token;
+    vector<string> header;
+
+    getline(file, line);
+    stringstream hs(line);
+    while (getline(hs, token, ','))
+        header.push_back(token);
+
+    auto find = [&header](const string& name){
+        for (size_t i = 0; i < header.size(); ++i)
+            if (header[i] == name)
+                return i;
+        return header.size();
+    };
+    size_t tIdx = find(timeColumn);
+    vector<size_t> idx;
+    for (const auto& name : valueColumns)
+        idx.push_back(find(name));
+
+    vector<pair<DateTime, Vector>> rows;
+    while (getline(file, line)){
+        if (line.empty())
+            continue;
+        stringstream ss(line);
+        vector<string> values;
+        while (getline(ss, token, ','))
+            values.push_back(token);
+
+        DateTime t(values[tIdx]);
+        rows.emplace_back(t, Vector{stod(values[idx[0]]),
+                                    stod(values[idx[1]]),
+                                    stod(values[idx[2]])});
+    }
+    return rows.size();
+}
+
+int main(int argc, char* argv[])
+{
+    string csvFile = "../data/csv/position-eci_251001-1y-10s.csv";
+    string timeColumn = "Time (UTCG)";
+    vector<string> columns = {"Position (x)", "Position (y)", "Position (z)"};
+    if (argc == 6){
+        csvFile = argv[1];
+        timeColumn = argv[2];
+        columns = {argv[3], argv[4], argv[5]};
+    }
+
+    bench::Timer timer;
+    size_t legacyRows = legacyRead(csvFile, timeColumn, columns);
+    double legacy = timer.seconds();
+
+    timer.reset();
+    CsvSeries single = readCsvSeries(csvFile, timeColumn, columns, 1);
+    double oneThread = timer.seconds();
+
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    timer.reset();
+    CsvSeries parallel = readCsvSeries(csvFile, timeColumn, columns, threads);
+    double allThreads = timer.seconds();
+
+    cout << "Rows                 : " << single.rows()
+         << " (legacy " << legacyRows << ")" << endl;
+    bench::report("getline/stringstream/stod", legacy, legacyRows, "row");
+    bench::report("readCsvSeries (1 thread)", oneThread,
+                  single.rows(), "row");
+    bench::report("readCsvSeries (" + to_string(threads) + " threads)",
+                  allThreads, parallel.rows(), "row");
+
+    bool same = single.ticks == parallel.ticks
+             && single.values == parallel.values;
+    cout << "Chunked == sequential: " << (same ? "yes" : "NO") << endl;
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "DateTime.h"
+using namespace std;
+
+// Parsing and formatting STK time stamps ("1 Oct 2025 06:30:10.000"):
+// the get_time/mktime parser and localtime/ostringstream formatter
+// DateTime used before, against the hand written UTC versions. The
+// legacy code runs with TZ=UTC so both sides agree on the instant.
+
+using Clock = chrono::system_clock;
+
+// DateTime::parseDateTime before the rewrite (drops the milliseconds)
+static Clock::time_point legacyParse(const string& time_str)
+{
+    tm t = {};
+    istringstream ss(time_str);
+    ss >> get_time(&t, "%d %b %Y %H:%M:%S");
+    time_t time = mktime(&t);
+    return Clock::from_time_t(time);
+}
+
+// DateTime::display before the rewrite
+static string legacyDisplay(Clock::time_point tp)
+{
+    time_t time_t_format = Clock::to_time_t(tp);
+    auto milliseconds = chrono::duration_cast<chrono::milliseconds>(
+        tp.time_since_epoch()
+    ) % 1000;
+    tm tm_struct = *localtime(&time_t_format);
+
+    static const char* months[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    ostringstream oss;
+    oss << setfill('0')
+        << setw(2) << tm_struct.tm_mday << " "
+        << months[tm_struct.tm_mon] << " "
+        << (tm_struct.tm_year + 1900) << " "
+        << setw(2) << tm_struct.tm_hour << ":"
+        << setw(2) << tm_struct.tm_min << ":"
+        << setw(2) << tm_struct.tm_sec << "."
+        << setw(3) << milliseconds.count();
+    return oss.str();
+}
+
+int main()
+{
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    // One day at a 10 s cadence crossing a month and a year boundary,
+    // written the way STK does (unpadded day)
+    vector<string> stamps;
+    DateTime start("31 Dec 2025 12:00:00.000");
+    for (int i = 0; i < 8640; ++i){
+        string s = (start + i * 10.0).display();
+        if (s[0] == '0')
+            s.erase(0, 1);
+        stamps.push_back(s);
+    }
+
+    // Agreement with the legacy code on whole seconds
+    size_t mismatches = 0;
+    for (const string& s : stamps){
+        int64_t legacy = chrono::duration_cast<chrono::nanoseconds>(
+            legacyParse(s).time_since_epoch()).count();
+        DateTime t(s);
+        if (legacy != t.ticks()
+            || legacyDisplay(legacyParse(s)) != t.display())
+            ++mismatches;
+    }
+    DateTime fractional("1 Oct 2025 06:30:10.250");
+    cout << "Mismatches vs legacy : " << mismatches << " of "
+         << stamps.size() << endl;
+    cout << "Milliseconds kept    : " << fractional.display() << endl;
+
+    const int repeats = 50;
+    const double n = static_cast<double>(stamps.size()) * repeats;
+
+    bench::Timer timer;
+    for (int r = 0; r < repeats; ++r)
+        for (const string& s : stamps){
+            Clock::time_point tp = legacyParse(s);
+            bench::doNotOptimize(tp);
+        }
+    bench::report("parse (get_time/mktime)", timer.seconds(), n, "stamp");
+
+    timer.reset();
+    for (int r = 0; r < repeats; ++r)
+        for (const string& s : stamps){
+            DateTime t(s.data(), s.size());
+            bench::doNotOptimize(t);
+        }
+    bench::report("parse (DateTime)", timer.seconds(), n, "stamp");
+
+    vector<DateTime> times;
+    vector<Clock::time_point> points;
+    for (const string& s : stamps){
+        times.emplace_back(s);
+        points.push_back(legacyParse(s));
+    }
+
+    timer.reset();
+    for (int r = 0; r < repeats; ++r)
+        for (const Clock::time_point& tp : points){
+            string out = legacyDisplay(tp);
+            bench::doNotOptimize(out);
+        }
+    bench::report("display (localtime/ostringstream)", timer.seconds(), n,
+                  "stamp");
+
+    timer.reset();
+    for (int r = 0; r < repeats; ++r)
+        for (const DateTime& t : times){
+            string out = t.display();
+            bench::doNotOptimize(out);
+        }
+    bench::report("display (DateTime)", timer.seconds(), n, "stamp");
+
+    timer.reset();
+    char buffer[DateTime::formatLength];
+    for (int r = 0; r < repeats; ++r)
+        for (const DateTime& t : times){
+            size_t len = t.format(buffer);
+            bench::doNotOptimize(buffer[len - 1]);
+        }
+    bench::report("format into buffer (DateTime)", timer.seconds(), n,
+                  "stamp");
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "FieldCache.h"
+#include "Numerics.h"
+using namespace std;
+
+// A sweep's field access with and without FieldCache, on a synthetic STK
+// style export (1 s cadence, one day). Each run covers 2 h at 0.01 s.
+// Uncached, every run opens the CSV and interpolates at each step; the
+// cache does that once and later runs map the result. Checks that the
+// cached samples equal the direct interpolation on the grid, how close
+// they stay between grid points, and that threads racing on an empty
+// cache build a single entry.
+//
+// Usage: ./bench_field_cache.out
+
+int main()
+{
+    string csvFile = (filesystem::temp_directory_path()
+                      / "bench_field_cache.csv").string();
+    string cacheDir = (filesystem::temp_directory_path()
+                       / "bench_field_cache").string();
+    filesystem::remove_all(cacheDir);
+
+    DateTime first("01 Oct 2025 00:00:00.000");
+    const size_t rows = 86400;
+    {
+        ofstream out(csvFile);
+        out << "\"Time (UTCG)\",\"x (nT)\",\"y (nT)\",\"z (nT)\"\n";
+        char stamp[DateTime::formatLength];
+        for (size_t i = 0; i < rows; ++i){
+            double s = static_cast<double>(i);
+            out.write(stamp, (first + s).format(stamp));
+            out << ',' << 20000.0 * sin(s * 1e-3)
+                << ',' << 15000.0 * cos(s * 7e-4)
+                << ',' << -30000.0 + 500.0 * sin(s * 3e-3) << '\n';
+        }
+    }
+
+    const string t = "\"Time (UTCG)\"";
+    const string x = "\"x (nT)\"", y = "\"y (nT)\"", z = "\"z (nT)\"";
+    DateTime start = first + 36000.0;
+    DateTime stop = start + 2 * 3600.0;
+    const double dt = 0.01;
+
+    // One run's field access: open, then a lookup per step
+    auto run = [&](const SampleDataVector& data, vector<Vector>* out){
+        SampleCursor at;
+        for (DateTime now = start; now < stop; now = now + dt){
+            Vector v = data.lagrangeInterpolate(now, at);
+            if (out)
+                out->push_back(v);
+            bench::doNotOptimize(v);
+        }
+    };
+
+    vector<Vector> direct, cached;
+    bench::Timer timer;
+    {
+        SampleDataVector data = SampleDataVector::openWindow(
+            csvFile, t, {x, y, z}, start, stop);
+        run(data, &direct);
+    }
+    double uncachedSeconds = timer.seconds();
+
+    FieldCache cache(cacheDir);
+    timer.reset();
+    SampleDataVector built = cache.field(csvFile, t, x, y, z,
+                                         start, stop, dt);
+    double buildSeconds = timer.seconds();
+
+    timer.reset();
+    double openSeconds;
+    {
+        SampleDataVector data = cache.field(csvFile, t, x, y, z,
+                                            start, stop, dt);
+        openSeconds = timer.seconds();
+        run(data, &cached);
+    }
+    double cachedSeconds = timer.seconds();
+
+    size_t mismatches = direct.size() == cached.size() ? 0 : 1;
+    for (size_t k = 0; k < min(direct.size(), cached.size()); ++k){
+        if (direct[k][0] != cached[k][0] || direct[k][1] != cached[k][1]
+            || direct[k][2] != cached[k][2])
+            ++mismatches;
+    }
+
+    // Between grid points (adaptive steps) against the source
+    double maxRel = 0;
+    {
+        SampleDataVector source(csvFile, t, {x, y, z});
+        SampleCursor a, b;
+        for (DateTime now = start + 0.0037; now < stop; now = now + 0.731){
+            Vector v = source.lagrangeInterpolate(now, a);
+            Vector w = built.lagrangeInterpolate(now, b);
+            maxRel = max(maxRel, (v - w).magnitude() / v.magnitude());
+        }
+    }
+
+    cout << "Steps per run                : " << direct.size() << endl
+         << "Entry                        : "
+         << filesystem::file_size(cache.path(csvFile, t, x, y, z,
+                                             start, stop, dt)) / 1048576
+         << " MB" << endl;
+    bench::report("run, uncached (CSV window)", uncachedSeconds, 1, "run");
+    bench::report("first run, building cache", buildSeconds, 1, "run");
+    bench::report("run, cached (open + steps)", cachedSeconds, 1, "run");
+    bench::report("  of which open", openSeconds, 1, "run");
+    cout << "Grid mismatches vs direct    : " << mismatches << endl
+         << "Max rel. error between steps : " << scientific
+         << maxRel << fixed << endl;
+
+    // Eight threads asking for a missing entry at once
+    DateTime stop2 = stop + 600.0;
+    vector<SampleDataVector> results(8);
+    vector<thread> threads;
+    for (size_t i = 0; i < results.size(); ++i)
+        threads.emplace_back([&, i]{
+            results[i] = cache.field(csvFile, t, x, y, z, start, stop2, dt);
+        });
+    for (thread& th : threads)
+        th.join();
+
+    size_t entries = 0, others = 0;
+    for (const auto& f : filesystem::directory_iterator(cacheDir)){
+        if (f.path().extension() == ".bin")
+            ++entries;
+        else
+            ++others;
+    }
+    size_t differ = 0;
+    for (const SampleDataVector& r : results){
+        if (r.size() != results[0].size()
+            || (r.valueAt(r.size() / 2) - results[0].valueAt(r.size() / 2))
+                   .magnitude() != 0.0)
+            ++differ;
+    }
+    cout << "Entries after the race       : " << entries << " (2 expected), "
+         << others << " stray files, " << differ << " differing" << endl;
+
+    filesystem::remove(csvFile);
+    filesystem::remove_all(cacheDir);
+    return mismatches == 0 && entries == 2 && others == 0 && differ == 0
+               ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "GeomagneticField.h"
+using namespace std;
+
+// GeomagneticField against a textbook evaluation in spherical
+// coordinates (Schmidt Legendre functions by their theta recursion,
+// recomputed on every call), then the cost of the single and batch paths
+// and the field along the STK position export.
+//
+// The coefficients are the built-in IGRF-13 set to degree 4 plus small
+// made-up terms to degree 13, written to a temporary file in the IGRF
+// table format so that the loader is exercised too.
+// The built-in table itself is checked through its dipole moment
+// against the published IGRF-13 value.
+//
+// Usage: ./bench_geomagnetic.out [position.csv]   (run from bin/)
+
+struct Term { int n, m; double g, h; };
+
+static vector<Term> makeTerms()
+{
+    vector<Term> terms = {
+        {1, 0, -29404.8, 0.0},    {1, 1, -1450.9, 4652.5},
+        {2, 0, -2499.6, 0.0},     {2, 1, 2982.0, -2991.6},
+        {2, 2, 1677.0, -734.6},   {3, 0, 1363.2, 0.0},
+        {3, 1, -2381.2, -82.1},   {3, 2, 1236.2, 241.9},
+        {3, 3, 525.7, -543.4},    {4, 0, 903.0, 0.0},
+        {4, 1, 809.5, 281.9},     {4, 2, 86.3, -158.4},
+        {4, 3, -309.4, 199.7},    {4, 4, 48.0, -349.7},
+    };
+    mt19937 rng(7);
+    normal_distribution<double> unit(0.0, 1.0);
+    for (int n = 5; n <= 13; ++n)
+        for (int m = 0; m <= n; ++m)
+        {
+            double size = 400.0 * pow(0.6, n - 5);
+            terms.push_back({n, m, size * unit(rng),
+                             m == 0 ? 0.0 : size * unit(rng)});
+        }
+    return terms;
+}
+
+// Field in Earth-fixed axes by the spherical formulas (nT)
+static Vector reference(const vector<Term>& terms, int degree,
+                        const Vector& p)
+{
+    const double a = GeomagneticField::referenceRadius;
+    double r = p.magnitude();
+    double theta = acos(p[2] / r), phi = atan2(p[1], p[0]);
+    double ct = cos(theta), st = sin(theta);
+
+    double P[15][15] = {}, dP[15][15] = {};
+    P[0][0] = 1.0;
+    for (int n = 1; n <= degree; ++n)
+        for (int m = 0; m <= n; ++m)
+        {
+            if (n == m){
+                double k = n == 1 ? 1.0 : sqrt((2.0 * n - 1.0) / (2.0 * n));
+                P[n][n] = k * st * P[n - 1][n - 1];
+                dP[n][n] = k * (st * dP[n - 1][n - 1]
+                                + ct * P[n - 1][n - 1]);
+            } else {
+                double k2 = n >= 2 ? sqrt(double((n - 1) * (n - 1) - m * m))
+                                   : 0.0;
+                double pm2 = n >= 2 ? P[n - 2][m] : 0.0;
+                double dpm2 = n >= 2 ? dP[n - 2][m] : 0.0;
+                double k = sqrt(double(n * n - m * m));
+                P[n][m] = ((2.0 * n - 1.0) * ct * P[n - 1][m] - k2 * pm2) / k;
+                dP[n][m] = ((2.0 * n - 1.0) * (ct * dP[n - 1][m]
+                                               - st * P[n - 1][m])
+                            - k2 * dpm2) / k;
+            }
+        }
+
+    double br = 0, bt = 0, bp = 0;
+    for (const Term& c : terms)
+    {
+        if (c.n > degree)
+            continue;
+        double f = pow(a / r, c.n + 2);
+        double cm = cos(c.m * phi), sm = sin(c.m * phi);
+        br += (c.n + 1) * f * (c.g * cm + c.h * sm) * P[c.n][c.m];
+        bt -= f * (c.g * cm + c.h * sm) * dP[c.n][c.m];
+        bp -= f * c.m * (-c.g * sm + c.h * cm) * P[c.n][c.m] / st;
+    }
+
+    double cp = cos(phi), sp = sin(phi);
+    return Vector{st * cp * br + ct * cp * bt - sp * bp,
+                  st * sp * br + ct * sp * bt + cp * bp,
+                  ct * br - st * bt};
+}
+
+int main(int argc, char* argv[])
+{
+    string positionFile = argc > 1 ? argv[1]
+        : "../data/csv/position-eci_251001-1y-10s.csv";
+
+    vector<Term> terms = makeTerms();
+    string coeffFile = (filesystem::temp_directory_path()
+                        / "bench_geomagnetic_coeffs.txt").string();
+    {
+        ofstream out(coeffFile);
+        out << setprecision(17)
+            << "# test model in the IGRF table layout\n"
+            << "c/s deg ord IGRF SV\n"
+            << "g/h n m 2020.0 2020-25\n";
+        for (const Term& c : terms){
+            out << "g " << c.n << " " << c.m << " " << c.g << " 0\n";
+            if (c.m > 0)
+                out << "h " << c.n << " " << c.m << " " << c.h << " 0\n";
+        }
+    }
+    GeomagneticField full(coeffFile);
+    filesystem::remove(coeffFile);
+    DateTime epoch("01 Jan 2020 00:00:00.000");
+
+    // Random positions from 300 to 2000 km altitude
+    mt19937 rng(11);
+    uniform_real_distribution<double> unit(-1.0, 1.0);
+    uniform_real_distribution<double> radius(6678.0, 8378.0);
+    const size_t count = 20000;
+    vector<double> x(count), y(count), z(count);
+    for (size_t k = 0; k < count; ++k){
+        Vector d{unit(rng), unit(rng), unit(rng)};
+        Vector p = d.direction() * radius(rng);
+        x[k] = p[0]; y[k] = p[1]; z[k] = p[2];
+    }
+
+    // Accuracy (Earth-fixed; the reference has no time dependence)
+    double maxRel = 0;
+    for (size_t k = 0; k < count; ++k){
+        Vector p{x[k], y[k], z[k]};
+        Vector a = full.fieldECEF(p, epoch);
+        Vector b = reference(terms, 13, p);
+        maxRel = max(maxRel, (a - b).magnitude() / b.magnitude());
+    }
+    GeomagneticField builtIn;
+    Vector pole = builtIn.fieldECEF({0, 0, GeomagneticField::referenceRadius},
+                                    epoch);
+    GeomagneticField dipole = builtIn;
+    dipole.setDegree(1);
+    Vector dipolePole = dipole.fieldECEF(
+        {0, 0, GeomagneticField::referenceRadius}, epoch);
+
+    // Built-in table against the same terms loaded from file
+    GeomagneticField truncated = full;
+    truncated.setDegree(4);
+    double builtInDiff = 0;
+    for (size_t k = 0; k < count; k += 10){
+        Vector p{x[k], y[k], z[k]};
+        builtInDiff = max(builtInDiff,
+                          (builtIn.fieldECEF(p, epoch)
+                           - truncated.fieldECEF(p, epoch)).magnitude());
+    }
+
+    cout << "Max relative error, degree 13 : " << scientific
+         << setprecision(2) << maxRel << endl
+         << "Built-in vs loaded, degree 4  : " << builtInDiff << " nT"
+         << endl << fixed << setprecision(1)
+         << "Dipole field at north pole   : " << dipolePole[2]
+         << " nT (2 g10 = -58809.6)" << endl
+         << "Degree 4 field at north pole : " << pole.display() << endl;
+
+    // The built-in dipole against the published IGRF-13 dipole moment
+    // for 2020.0 (7.71e22 A m^2), 4 pi a^3 B0 / mu_0: B0 is the length
+    // of (g10, g11, h11), read off the radial field 2 g10, 2 g11, 2 h11
+    // at the pole and on the x and y axes
+    const double a = GeomagneticField::referenceRadius;
+    double b0 = 0.5 * Vector{dipole.fieldECEF({0, 0, a}, epoch)[2],
+                             dipole.fieldECEF({a, 0, 0}, epoch)[0],
+                             dipole.fieldECEF({0, a, 0}, epoch)[1]}
+                          .magnitude();
+    double moment = b0 * 1e-9 * pow(a * 1e3, 3) * 1e7;
+    cout << scientific << setprecision(3)
+         << "Dipole moment (IGRF-13 2020) : " << moment
+         << " A m^2 (published 7.71e22)" << endl << fixed;
+    if (fabs(moment - 7.71e22) > 0.005e22)
+        return 1;
+
+    // Speed, inertial frame, degree 13 and 4
+    vector<DateTime> times(count, DateTime("01 Oct 2025 06:30:00.000"));
+    for (size_t k = 0; k < count; ++k)
+        times[k] = times[k] + 0.1 * static_cast<double>(k);
+    vector<double> bx(count), by(count), bz(count);
+
+    for (int degree : {13, 4}){
+        GeomagneticField model = full;
+        model.setDegree(degree);
+        string label = "degree " + to_string(degree);
+
+        bench::Timer timer;
+        for (size_t k = 0; k < count; k += 4){
+            Vector b = reference(terms, degree, {x[k], y[k], z[k]});
+            bench::doNotOptimize(b);
+        }
+        bench::report("  spherical reference, " + label, timer.seconds(),
+                      count / 4.0, "eval");
+
+        size_t mismatches = 0;
+        timer.reset();
+        for (size_t k = 0; k < count; ++k){
+            Vector b = model.fieldECI({x[k], y[k], z[k]}, times[k]);
+            bench::doNotOptimize(b);
+        }
+        bench::report("  single, " + label, timer.seconds(), count, "eval");
+
+        timer.reset();
+        model.fieldECI(times.data(), x.data(), y.data(), z.data(), count,
+                       bx.data(), by.data(), bz.data());
+        bench::report("  batch, " + label, timer.seconds(), count, "eval");
+
+        for (size_t k = 0; k < count; ++k){
+            Vector b = model.fieldECI({x[k], y[k], z[k]}, times[k]);
+            if (b[0] != bx[k] || b[1] != by[k] || b[2] != bz[k])
+                ++mismatches;
+        }
+        cout << "  batch mismatches           : " << mismatches << endl;
+        if (mismatches)
+            return 1;
+    }
+
+    // Along the orbit, from the position export, at 1 s
+    if (filesystem::exists(positionFile)){
+        OrbitField orbit(positionFile);
+        const OrbitField::PositionSeries& pos = orbit.positions();
+        DateTime first = pos.timeAt(0);
+        double span = pos.timeAt(pos.size() - 1) - first;
+
+        double lo = 1e9, hi = 0;
+        SampleCursor at;
+        bench::Timer timer;
+        size_t queries = 0;
+        for (double s = 0; s < span; s += 1.0, ++queries){
+            double b = orbit.field(first + s, at).magnitude();
+            lo = min(lo, b);
+            hi = max(hi, b);
+        }
+        bench::report("orbit field (position + model)", timer.seconds(),
+                      static_cast<double>(queries), "query");
+        cout << "|B| along orbit              : " << lo << " .. " << hi
+             << " nT over " << span / 3600.0 << " h" << endl;
+    }
+
+    return maxRel < 1e-10 ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "HysteresisModel.h"
+#include "HysteresisRodBank.h"
+#include "Quaternion.h"
+using namespace std;
+
+// The hysteresis models of HysteresisModel.h side by side, each as the
+// backend of a HysteresisRodBank: how fast a bank of mixed rods steps
+// with it (per atan kernel), and the loop a single rod traces in a
+// sinusoidal field (major loop at orbit field strengths, and a minor
+// loop well inside it).
+//
+// Only FlatleyAtan has a step without a loop of its own, so only its
+// pass vectorises (with the rational kernel); the others step per rod.
+
+// main.cpp's PMAC rods
+const double vol = 1.4e-8, nd = 0.002;
+const FlatleyLoop pmac = {1.59154, 0.35, 0.73, 0, 2};
+
+// A Jiles-Atherton loop of about the same saturation and coercivity
+const JilesAthertonLoop pmacJA = {0.73 / mu_0, 3.0, 1e-6, 1.6, 0.1};
+
+template <typename Model>
+typename Model::Loop loopFor();
+template <> FlatleyLoop loopFor<FlatleyAtan>() { return pmac; }
+template <> FlatleyLoop loopFor<FlatleyDifferential>() { return pmac; }
+template <> JilesAthertonLoop loopFor<JilesAtherton>() { return pmacJA; }
+
+struct LoopShape
+{
+    double bMax = 0;        // T
+    double remanence = 0;   // B where h falls through 0 (T)
+    double coercivity = 0;  // |h| where B falls through 0 (A/m)
+    double loss = 0;        // closed integral of h dB (J/m^3 per cycle)
+    double closure = 0;     // B at the end of the cycle less its start (T)
+};
+
+// Drives one rod along x with h = amplitude sin(2 pi t) for `cycles`
+// cycles and measures the last
+template <typename Model>
+LoopShape loopShape(double amplitude, int cycles, int stepsPerCycle)
+{
+    BasicHysteresisRodBank<Model> bank;
+    BasicHysteresisRod<Model> rod;
+    rod.volume = vol;
+    rod.demagFactor = nd;
+    rod.loop = loopFor<Model>();
+    bank.addRod(rod);
+
+    const array<Vector, 3> axes = {Vector{1, 0, 0}, Vector{0, 1, 0},
+                                   Vector{0, 0, 1}};
+    LoopShape shape;
+    double hLast = 0, bLast = 0, bStart = 0;
+    int total = cycles * stepsPerCycle;
+    for (int i = 1; i <= total; ++i){
+        double h = amplitude * sin(2 * M_PI * i / stepsPerCycle);
+        bank.update({h, 0, 0}, axes);
+        double b = bank.rodField(0);
+
+        if (i == total - stepsPerCycle)
+            bStart = b;
+        if (i > total - stepsPerCycle){
+            shape.bMax = max(shape.bMax, fabs(b));
+            shape.loss += 0.5 * (h + hLast) * (b - bLast);
+            if (hLast > 0 && h <= 0)
+                shape.remanence = bLast + (b - bLast) * hLast / (hLast - h);
+            if (bLast > 0 && b <= 0)
+                shape.coercivity = fabs(hLast + (h - hLast) * bLast
+                                                / (bLast - b));
+        }
+        hLast = h;
+        bLast = b;
+    }
+    shape.closure = bLast - bStart;
+    return shape;
+}
+
+// A bank of n rods with axes scattered about the body axes
+template <typename Model>
+BasicHysteresisRodBank<Model> mixedBank(size_t n, Flatley::Kernel kernel)
+{
+    BasicHysteresisRodBank<Model> bank;
+    mt19937 gen(3);
+    uniform_real_distribution<double> jitter(-0.2, 0.2);
+    for (size_t i = 0; i < n; ++i){
+        BasicHysteresisRod<Model> rod;
+        Vector axis = {0, 0, 0};
+        axis[i % 3] = 1;
+        axis = axis + Vector{jitter(gen), jitter(gen), jitter(gen)};
+        rod.axis = axis / axis.magnitude();
+        rod.volume = vol * (1 + jitter(gen));
+        rod.demagFactor = nd * (1 + jitter(gen));
+        rod.loop = loopFor<Model>();
+        bank.addRod(rod);
+    }
+    bank.setKernel(kernel);
+    return bank;
+}
+
+template <typename Model>
+void compare(const vector<Vector>& fields,
+             const vector<array<Vector, 3>>& attitudes,
+             const string& substeps)
+{
+    cout << endl << Model::name << " (substeps: " << substeps << ")"
+         << endl;
+
+    const size_t n = 300;
+    const int repeats = 5;
+    const pair<Flatley::Kernel, const char*> kernels[] = {
+        {Flatley::Kernel::Exact, "exact"},
+        {Flatley::Kernel::Rational, "rational"}};
+    for (const auto& [kernel, name] : kernels){
+        BasicHysteresisRodBank<Model> bank = mixedBank<Model>(n, kernel);
+        bench::Timer timer;
+        for (int r = 0; r < repeats; ++r)
+            for (size_t i = 0; i < fields.size(); ++i){
+                bank.update(fields[i], attitudes[i]);
+                Vector m = bank.moment();
+                bench::doNotOptimize(m);
+            }
+        double seconds = timer.seconds();
+        bench::report("  " + to_string(n) + " rods, " + name, seconds,
+                      static_cast<double>(repeats) * fields.size() * n,
+                      "rod");
+    }
+
+    cout << scientific << setprecision(3);
+    for (double amplitude : {30.0, 2.0}){
+        LoopShape s = loopShape<Model>(amplitude, 4, 2000);
+        cout << "  loop at " << fixed << setprecision(0) << setw(2)
+             << amplitude << " A/m:" << scientific << setprecision(3)
+             << " Bmax " << s.bMax << " T, Br " << s.remanence
+             << " T, Hc " << s.coercivity << " A/m, loss " << s.loss
+             << " J/m^3, closure " << s.closure << " T" << endl;
+    }
+    cout << fixed;
+}
+
+int main()
+{
+    // As bench_rod_bank: a field of a few tens of A/m turning through
+    // the orbit, a satellite tumbling at about 1 deg/s
+    const double dt = 0.1;
+    const int steps = 5000;
+    vector<Vector> fields(steps);
+    vector<array<Vector, 3>> attitudes(steps);
+    Quaternion q;
+    Quaternion spin = Quaternion::fromRotationVector(
+        Vector{0.011, -0.007, 0.015} * dt);
+    for (int i = 0; i < steps; ++i){
+        double s = i * dt * 1e-3;
+        fields[i] = {30 * cos(s), 25 * sin(1.3 * s), 18 * sin(0.7 * s + 1)};
+        attitudes[i] = q.toAxes();
+        q = (spin * q).normalized();
+    }
+
+    compare<FlatleyAtan>(fields, attitudes, "none");
+    compare<FlatleyDifferential>(fields, attitudes,
+                                 "adaptive, at most "
+                                 + to_string(FlatleyDifferential::maxSubsteps));
+    compare<JilesAtherton>(fields, attitudes,
+                           "|dh| / (a / 4) per step, at most "
+                           + to_string(JilesAtherton::maxSubsteps));
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "OrbitPropagator.h"
+#include "Satellite.h"
+#include "Simulation.h"
+using namespace std;
+
+// Accuracy of the integrators against step size. main.cpp's satellite
+// (PMAC rods, tumbling at 0.17 rad/s per axis) runs for ten minutes in
+// the field along a propagated 500 km orbit, once per integrator and
+// step; the end state is compared with RK4 at a step 32 times finer
+// than the finest here. The order column is log2 of the error ratio of
+// consecutive steps. DP5 is the fifth order solution of DormandPrince45
+// taken at a fixed step, without its error control.
+//
+// The first run keeps every rod on one branch (a branch tolerance no
+// field reaches), so the torque is smooth and the integrators show their
+// own order. The others are per hysteresis model as simulated: branch
+// changes of the inverse tangent model jump the torque at times only
+// known to a step, and Jiles-Atherton's forward Euler in h depends on
+// the steps h is sampled at, which bounds the order any integrator
+// reaches on them.
+
+struct EndState
+{
+    Quaternion attitude;
+    Vector angularVelocity;
+    double seconds;     // wall time of the run
+};
+
+template <typename Model>
+EndState run(const typename Model::Loop& loop, const OrbitField& field,
+             const DateTime& start, double duration, double dt,
+             IntegratorType integrator, double branchTolerance)
+{
+    BasicSatellite<Model> satellite(
+        Matrix{0.0067, 0.0000, 0.0000,
+               0.0003, 0.0333, 0.0000,
+               0.0000, 0.0000, 0.0333},
+        {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+        {0.17, 0.17, 0.17}, {0.00001, 0, 0},
+        12.0, 1.4e-8, 0, 3, 3, 0, loop);
+    satellite.setHystTolerance(branchTolerance);
+
+    SimulationContext ctx(start);
+    ctx.orientation = satellite.getOrientation();
+    long steps = lround(duration / dt);
+
+    bench::Timer timer;
+    for (long i = 0; i < steps; i++){
+        integrateStep(satellite, field, ctx, dt, integrator);
+        ctx.time = start + (i + 1) * dt;
+    }
+    return {satellite.getAttitude(), satellite.getAngularVelocity(),
+            timer.seconds()};
+}
+
+// Angle between two attitudes (rad), from the rotation taking one to
+// the other (atan2 keeps small angles that acos of the dot would lose)
+static double angleBetween(const Quaternion& a, const Quaternion& b)
+{
+    Quaternion d = a.conjugate() * b;
+    double s = sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+    return 2 * atan2(s, fabs(d.w));
+}
+
+template <typename Model>
+void convergence(const string& label, const typename Model::Loop& loop,
+                 const OrbitField& field, const DateTime& start,
+                 double duration, double branchTolerance = 0)
+{
+    const vector<double> steps = {0.8, 0.4, 0.2, 0.1, 0.05, 0.025};
+    EndState reference = run<Model>(loop, field, start, duration,
+                                    steps.back() / 32,
+                                    IntegratorType::RungeKutta4,
+                                    branchTolerance);
+
+    cout << endl << label << ", " << fixed << setprecision(0) << duration
+         << " s" << endl
+         << "  integrator   dt (s)   |dw| (rad/s)  order"
+         << "   angle (rad)  order   step (us)" << endl;
+
+    const pair<IntegratorType, const char*> integrators[] = {
+        {IntegratorType::Euler, "Euler"},
+        {IntegratorType::RungeKutta4, "RK4"},
+        {IntegratorType::DormandPrince45, "DP5"}};
+    for (const auto& [integrator, name] : integrators){
+        double lastW = 0, lastAngle = 0;
+        for (double dt : steps){
+            EndState end = run<Model>(loop, field, start, duration, dt,
+                                      integrator, branchTolerance);
+            double dw = (end.angularVelocity
+                         - reference.angularVelocity).magnitude();
+            double angle = angleBetween(end.attitude, reference.attitude);
+
+            cout << "  " << left << setw(10) << name << right << fixed
+                 << setprecision(3) << setw(8) << dt << scientific
+                 << setprecision(2) << setw(14) << dw << fixed
+                 << setprecision(1) << setw(7)
+                 << (lastW > 0 ? log2(lastW / dw) : 0.0) << scientific
+                 << setprecision(2) << setw(14) << angle << fixed
+                 << setprecision(1) << setw(7)
+                 << (lastAngle > 0 ? log2(lastAngle / angle) : 0.0)
+                 << setprecision(2) << setw(12)
+                 << end.seconds / lround(duration / dt) * 1e6 << endl;
+            lastW = dw;
+            lastAngle = angle;
+        }
+    }
+}
+
+int main()
+{
+    DateTime start("01 Oct 2025 07:00:00.000");
+    OrbitField field = orbitField(
+        OrbitPropagator::circular(500.0, 98.0 * M_PI / 180.0, start));
+    const double duration = 600;
+
+    const FlatleyLoop pmac = {1.59154, 0.35, 0.73, 0, 2};
+    convergence<FlatleyAtan>("Flatley (one branch, smooth torque)", pmac,
+                             field, start, duration, 1e9);
+    convergence<FlatleyAtan>(FlatleyAtan::name, pmac, field, start,
+                             duration);
+    convergence<FlatleyDifferential>(FlatleyDifferential::name, pmac, field,
+                                     start, duration);
+    convergence<JilesAtherton>(JilesAtherton::name,
+                               {0.73 / mu_0, 3.0, 1e-6, 1.6, 0.1}, field,
+                               start, duration);
+    return 0;
+}
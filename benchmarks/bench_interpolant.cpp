@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "Numerics.h"
+using namespace std;
+
+// Queries per second of SampleDataVector::lagrangeInterpolate with and
+// without the prebuilt per-interval interpolant, for an ordered sweep
+// (the simulate() access pattern) and for random times, and the largest
+// relative difference between the two over the whole series, including
+// both end intervals and a little extrapolation. The same queries are
+// repeated on an irregularly spaced copy to time the binary search
+// fallback of the uniform grid lookup.
+//
+// Usage: ./bench_interpolant.out [file.csv time_col x_col y_col z_col]
+// Defaults to the position export in data/csv (run from bin/).
+
+static double relDiff(const Vector& a, const Vector& b)
+{
+    return (a - b).magnitude() / max(a.magnitude(), 1e-300);
+}
+
+int main(int argc, char* argv[])
+{
+    string csvFile = "../data/csv/position-eci_251001-1y-10s.csv";
+    string timeColumn = "Time (UTCG)";
+    string colX = "Position (x)";
+    string colY = "Position (y)";
+    string colZ = "Position (z)";
+    if (argc == 6){
+        csvFile = argv[1];
+        timeColumn = argv[2];
+        colX = argv[3];
+        colY = argv[4];
+        colZ = argv[5];
+    }
+
+    SampleDataVector direct(csvFile, timeColumn, {colX, colY, colZ});
+    direct.sort();
+
+    bench::Timer timer;
+    SampleDataVector table = direct;
+    table.buildInterpolant();
+    double buildSeconds = timer.seconds();
+
+    size_t n = direct.size();
+    DateTime first = direct.timeAt(0);
+    double span = direct.timeAt(n - 1) - first;
+    cout << "Samples              : " << n << endl;
+    bench::report("build interpolant", buildSeconds, n, "sample");
+
+    // Ordered sweep, ~10 queries per sample interval, running a little
+    // past both ends
+    const size_t queries = 10 * n;
+    vector<DateTime> sweep(queries);
+    for (size_t k = 0; k < queries; ++k)
+        sweep[k] = first + ((span + 20.0) * k / (queries - 1) - 10.0);
+
+    double maxRel = 0;
+    for (const DateTime& t : sweep)
+        maxRel = max(maxRel, relDiff(direct.lagrangeInterpolate(t),
+                                     table.lagrangeInterpolate(t)));
+    cout << "Max relative diff    : " << scientific << setprecision(2)
+         << maxRel << endl;
+
+    vector<DateTime> shuffled = sweep;
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(42));
+
+    const int repeats = 10;
+    auto run = [&](const SampleDataVector& data,
+                   const vector<DateTime>& times, const string& label){
+        bench::Timer t;
+        for (int r = 0; r < repeats; ++r)
+            for (const DateTime& time : times){
+                Vector v = data.lagrangeInterpolate(time);
+                bench::doNotOptimize(v);
+            }
+        bench::report(label, t.seconds(),
+                      static_cast<double>(times.size()) * repeats, "query");
+    };
+
+    run(direct, sweep,    "lagrange, ordered (direct)");
+    run(table,  sweep,    "lagrange, ordered (interpolant)");
+    run(direct, shuffled, "lagrange, random (direct)");
+    run(table,  shuffled, "lagrange, random (interpolant)");
+
+    // One extra sample far past the end makes the spacing irregular, so
+    // lookups fall back to the hinted binary search
+    SampleDataVector irregular = direct;
+    irregular.addSample(direct.timeAt(n - 1) + 1e6, direct.valueAt(n - 1));
+    irregular.sort();
+    cout << "Uniform grid         : " << (direct.isUniform() ? "yes" : "no")
+         << " (irregular copy: "
+         << (irregular.isUniform() ? "yes" : "no") << ")" << endl;
+    run(irregular, sweep,    "lagrange, ordered (irregular)");
+    run(irregular, shuffled, "lagrange, random (irregular)");
+
+    return maxRel < 1e-12 ? 0 : 1;
+}
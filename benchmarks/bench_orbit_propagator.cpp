@@ -0,0 +1,179 @@
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "Bench.h"
+#include "GeomagneticField.h"
+#include "OrbitPropagator.h"
+using namespace std;
+
+// OrbitPropagator against the STK position export it replaces, then
+// the cost of a position and a field query from either source, and
+// checks of the J2 rates on a sweep of circular orbits (a sun-synchronous
+// one must turn its node 0.9856 deg/day) and of fromState().
+//
+// The bundled export is not inertial: its orbit plane turns about z at
+// twice the Earth rate, as an Earth-fixed export rotated the wrong way
+// would. So the comparison uses what a turn about z leaves alone, the
+// radius and z, for a circular orbit fitted to the export's first
+// samples. The export is two-body, so Kepler should follow it and J2
+// shows how far the oblateness it leaves out moves the orbit.
+//
+// Usage: ./bench_orbit_propagator.out [position.csv]   (run from bin/)
+
+int main(int argc, char* argv[])
+{
+    string positionFile = argc > 1 ? argv[1]
+        : "../data/csv/position-eci_251001-1y-10s.csv";
+    const double deg = M_PI / 180.0;
+
+    // Sweep: nodal rate and period of circular orbits
+    DateTime epoch("01 Oct 2025 00:00:00.000");
+    cout << "Altitude  Incl.   Period     Node rate" << endl;
+    for (double altitude : {400.0, 600.0, 800.0})
+        for (double incl : {51.6, 97.8, 98.6})
+        {
+            OrbitPropagator o = OrbitPropagator::circular(altitude,
+                                                          incl * deg, epoch);
+            cout << fixed << setprecision(1) << setw(6) << altitude
+                 << " km " << setw(5) << incl << "  " << setw(6)
+                 << o.period() / 60.0 << " min  " << setprecision(4)
+                 << setw(8) << o.raanRate() / deg * 86400.0 << " deg/day"
+                 << endl;
+        }
+
+    // Velocity is the derivative of position, and a Kepler orbit started
+    // from one of its own states is the same orbit
+    OrbitElements el;
+    el.semiMajorAxis = 7100.0;
+    el.eccentricity = 0.02;
+    el.inclination = 63.4 * deg;
+    el.raan = 0.3;
+    el.argPerigee = 1.1;
+    el.meanAnomaly = 2.0;
+    el.epoch = epoch;
+    OrbitPropagator kepler(el, OrbitPropagator::Model::Kepler);
+    OrbitPropagator j2(el);
+
+    double maxVelErr = 0, maxRoundTrip = 0;
+    for (double s = 0; s < 86400.0; s += 613.0){
+        DateTime t = epoch + s;
+        Vector fd = j2.position(t + 0.5) - j2.position(t + -0.5);
+        maxVelErr = max(maxVelErr, (fd - j2.velocity(t)).magnitude());
+
+        Vector r, v;
+        kepler.state(t, r, v);
+        OrbitPropagator again = OrbitPropagator::fromState(
+            r, v, t, OrbitPropagator::Model::Kepler);
+        DateTime later = t + 86400.0;
+        maxRoundTrip = max(maxRoundTrip, (again.position(later)
+                                          - kepler.position(later))
+                                             .magnitude());
+    }
+    cout << "Velocity vs finite difference : " << scientific
+         << setprecision(2) << maxVelErr << " km/s" << endl
+         << "fromState round trip, 1 day   : " << maxRoundTrip << " km"
+         << fixed << endl;
+
+    int status = maxVelErr < 1e-6 && maxRoundTrip < 1e-5 ? 0 : 1;
+    if (!filesystem::exists(positionFile)){
+        cout << "No position file, skipping comparison" << endl;
+        return status;
+    }
+
+    bench::Timer timer;
+    OrbitField fromFile(positionFile);
+    double loadSeconds = timer.seconds();
+    const OrbitField::PositionSeries& pos = fromFile.positions();
+    DateTime first = pos.timeAt(0);
+    double span = pos.timeAt(pos.size() - 1) - first;
+
+    // Circular fit: radius, inclination from the largest |z| over the
+    // first orbit, and where along the orbit the first sample sits
+    double radius = pos.valueAt(0).magnitude();
+    double zMax = 0;
+    for (size_t i = 0; i < pos.size() && pos.timeAt(i) - first < 6000.0; ++i)
+        zMax = max(zMax, fabs(pos.valueAt(i)[2]));
+    double incl = M_PI - asin(zMax / radius);        // retrograde (SSO)
+    Vector r0 = pos.valueAt(0);
+    double u0 = asin(r0[2] / (radius * sin(incl)));
+    if (pos.valueAt(1)[2] < r0[2])
+        u0 = M_PI - u0;
+
+    cout << endl << "Against " << positionFile << " ("
+         << setprecision(1) << span / 3600.0 << " h, loaded in "
+         << setprecision(3) << loadSeconds << " s)" << endl
+         << "  fitted circular orbit: " << setprecision(3)
+         << radius - OrbitPropagator::earthRadius << " km, "
+         << incl / deg << " deg" << endl;
+
+    for (auto model : {OrbitPropagator::Model::Kepler,
+                       OrbitPropagator::Model::J2})
+    {
+        OrbitPropagator orbit = OrbitPropagator::circular(
+            radius - OrbitPropagator::earthRadius, incl, first, 0.0, u0,
+            model);
+        const char* name = model == OrbitPropagator::Model::J2 ? "J2"
+                                                               : "Kepler";
+        cout << "  " << name << endl;
+
+        double marks[] = {3600.0, 6.0 * 3600.0, 24.0 * 3600.0, span};
+        size_t mark = 0;
+        double maxRadius = 0, maxZ = 0;
+        for (size_t i = 0; i < pos.size(); ++i){
+            DateTime t = pos.timeAt(i);
+            Vector r = orbit.position(t);
+            Vector truth = pos.valueAt(i);
+            maxRadius = max(maxRadius, fabs(r.magnitude()
+                                            - truth.magnitude()));
+            maxZ = max(maxZ, fabs(r[2] - truth[2]));
+            while (mark < 4 && t - first >= marks[mark] - 5.0){
+                cout << "    after " << setw(5) << setprecision(1)
+                     << marks[mark] / 3600.0 << " h: max radius error "
+                     << setw(7) << setprecision(3) << maxRadius
+                     << " km, z error " << setw(8) << maxZ << " km" << endl;
+                ++mark;
+            }
+        }
+    }
+
+    // Query cost, 1 s steps through the file span
+    OrbitField propagated(OrbitPropagator::circular(
+        radius - OrbitPropagator::earthRadius, incl, first, 0.0, u0));
+    size_t queries = static_cast<size_t>(span);
+    SampleCursor at;
+
+    timer.reset();
+    for (size_t k = 0; k < queries; ++k){
+        Vector p = fromFile.position(first + static_cast<double>(k), at);
+        bench::doNotOptimize(p);
+    }
+    bench::report("position, series (Lagrange<8>)", timer.seconds(),
+                  queries, "query");
+
+    timer.reset();
+    for (size_t k = 0; k < queries; ++k){
+        Vector p = propagated.position(first + static_cast<double>(k), at);
+        bench::doNotOptimize(p);
+    }
+    bench::report("position, propagator (J2)", timer.seconds(), queries,
+                  "query");
+
+    at = SampleCursor();
+    timer.reset();
+    for (size_t k = 0; k < queries; ++k){
+        Vector b = fromFile.field(first + static_cast<double>(k), at);
+        bench::doNotOptimize(b);
+    }
+    bench::report("field, series", timer.seconds(), queries, "query");
+
+    timer.reset();
+    for (size_t k = 0; k < queries; ++k){
+        Vector b = propagated.field(first + static_cast<double>(k), at);
+        bench::doNotOptimize(b);
+    }
+    bench::report("field, propagator", timer.seconds(), queries, "query");
+
+    return status;
+}
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <vector>
+#include "Bench.h"
+#include "Vector.h"
+#include "Matrix.h"
+using namespace std;
+
+// Compares the RK4 stage combination
+//      (k1 + k2 * 2.0 + k3 * 2.0 + k4) / 6.0
+// written with the expression templates (one fused pass, no temporaries)
+// against the same sum evaluated one operator at a time, the way the
+// Vector type worked before it was lazy.
+
+// Frames and tensors fold at compile time
+static constexpr Vector x_inrt = {1, 0, 0};
+static constexpr Vector y_inrt = {0, 1, 0};
+static constexpr Matrix inertia = {
+    0.0067, 0.0000, 0.0000,
+    0.0003, 0.0333, 0.0000,
+    0.0000, 0.0000, 0.0333
+};
+static_assert(x_inrt * y_inrt == 0.0, "inertial axes must be orthogonal");
+static_assert((x_inrt + y_inrt * 2.0)[1] == 2.0, "constexpr expression");
+static_assert((inertia + inertia * 2.0).coeff(4) == 0.0333 * 3.0,
+              "constexpr matrix expression");
+
+static Vector combineFused(const Vector& k1, const Vector& k2,
+                           const Vector& k3, const Vector& k4)
+{
+    return (k1 + k2 * 2.0 + k3 * 2.0 + k4) / 6.0;
+}
+
+// Materialises every intermediate result
+static Vector combineUnfused(const Vector& k1, const Vector& k2,
+                             const Vector& k3, const Vector& k4)
+{
+    Vector t1 = k2 * 2.0;
+    Vector t2 = k1 + t1;
+    Vector t3 = k3 * 2.0;
+    Vector t4 = t2 + t3;
+    Vector t5 = t4 + k4;
+    Vector t6 = t5 / 6.0;
+    return t6;
+}
+
+template <typename Combine>
+static double run(const vector<Vector>& k, vector<Vector>& out,
+                  int repeats, Combine combine)
+{
+    bench::Timer timer;
+    for (int r = 0; r < repeats; r++){
+        for (size_t i = 0; i + 3 < k.size(); i += 4)
+            out[i / 4] = combine(k[i], k[i + 1], k[i + 2], k[i + 3]);
+        bench::doNotOptimize(out[0]);
+    }
+    return timer.seconds();
+}
+
+int main()
+{
+    const size_t numStages = 4 * 4096;
+    const int repeats = 2000;
+
+    vector<Vector> k(numStages);
+    for (size_t i = 0; i < numStages; i++)
+        k[i] = {0.001 * i, 1.0 - 0.002 * i, 0.5 + 0.0001 * i};
+    vector<Vector> out(numStages / 4);
+
+    double combinations = static_cast<double>(numStages / 4) * repeats;
+
+    double fused = run(k, out, repeats, combineFused);
+    Vector checkFused = out[17];
+    double unfused = run(k, out, repeats, combineUnfused);
+    Vector checkUnfused = out[17];
+
+    bench::report("RK4 combine (fused)", fused, combinations, "comb");
+    bench::report("RK4 combine (unfused)", unfused, combinations, "comb");
+    cout << "Speed-up             : " << unfused / fused << "x" << endl
+         << "Max difference       : "
+         << (checkFused - checkUnfused).magnitude() << endl;
+
+    return 0;
+}
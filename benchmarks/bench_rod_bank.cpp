@@ -0,0 +1,195 @@
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "Bench.h"
+#include "Flatley.h"
+#include "HysteresisRodBank.h"
+#include "Quaternion.h"
+#include "Satellite.h"
+using namespace std;
+
+// HysteresisRodBank against the three Flatley objects Satellite used to
+// step (one per body axis, scaled by the rod count), on a tumbling
+// satellite in a rotating field. Checks that the bank with the three
+// axis stacks gives the same moment and field bit for bit, and how far
+// the rational atan kernel moves them. Times a satellite step's rod
+// update for the old path, the bank with three rods and the bank with
+// hundreds of rods of mixed axes and materials, per kernel.
+
+// The previous Satellite::updateHystM, reduced to the state it touches
+struct LegacyRods
+{
+    double vol, nd;
+    int num[3];
+    Flatley rod[3];
+    double moment[3] = {0, 0, 0};
+
+    LegacyRods(double volVal, double ndVal, int nx, int ny, int nz,
+               double hC, double bR, double bS, double q0, double p)
+        : vol(volVal), nd(ndVal), num{nx, ny, nz}
+    {
+        for (Flatley& f : rod)
+            f = Flatley(0, 0, 0, 0, 0, {1, 0, 0}, hC, bR, bS, q0, p);
+    }
+
+    void update(const Vector& H, const array<Vector, 3>& axes, double dt)
+    {
+        for (int i = 0; i < 3; ++i){
+            double B = rod[i].calcMagField(dt, H, axes[i]);
+            moment[i] = num[i] * vol * ((B / mu_0) - H*axes[i]) / (1 - nd);
+        }
+    }
+
+    Vector field() const
+    {
+        return rod[0].getMagField() + rod[1].getMagField()
+             + rod[2].getMagField();
+    }
+};
+
+static bool same(const Vector& a, const Vector& b)
+{
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+int main()
+{
+    // main.cpp's rods and loop (PMAC), with a demagnetisation factor
+    const double vol = 1.4e-8, nd = 0.002;
+    const double H_c = 1.59154, B_r = 0.35, B_s = 0.73, q_0 = 0, p = 2;
+    const double dt = 0.1;
+    const int steps = 20000;
+
+    // A field of a few tens of A/m turning through the orbit, and a
+    // satellite tumbling at about 1 deg/s
+    vector<Vector> fields(steps);
+    vector<array<Vector, 3>> attitudes(steps);
+    Quaternion q;
+    Quaternion spin = Quaternion::fromRotationVector(
+        Vector{0.011, -0.007, 0.015} * dt);
+    for (int i = 0; i < steps; ++i){
+        double s = i * dt * 1e-3;
+        fields[i] = {30 * cos(s), 25 * sin(1.3 * s), 18 * sin(0.7 * s + 1)};
+        attitudes[i] = q.toAxes();
+        q = (spin * q).normalized();
+    }
+
+    LegacyRods legacy(vol, nd, 3, 3, 0, H_c, B_r, B_s, q_0, p);
+    Satellite sat(Matrix{0.01, 0, 0, 0, 0.01, 0, 0, 0, 0.02},
+                  {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0, 0, 0}, {0, 0, 0},
+                  0, vol, nd, 3, 3, 0, FlatleyLoop{H_c, B_r, B_s, q_0, p});
+    HysteresisRodBank rational = sat.getHystRods();
+    rational.setKernel(Flatley::Kernel::Rational);
+
+    size_t mismatches = 0;
+    double maxMoment = 0, maxMomentErr = 0, maxFieldErr = 0;
+    for (int i = 0; i < steps; ++i){
+        sat.setAttitude(Quaternion::fromAxes(attitudes[i][0],
+                                             attitudes[i][1],
+                                             attitudes[i][2]));
+        array<Vector, 3> axes = sat.getOrientation();
+        sat.updateHystM(fields[i], dt);
+        legacy.update(fields[i], axes, dt);
+        rational.update(fields[i], axes);
+
+        Vector m = sat.getHystM();
+        Vector b = sat.getHystB();
+        if (!same(m, {legacy.moment[0], legacy.moment[1], legacy.moment[2]})
+            || !same(b, legacy.field()))
+            ++mismatches;
+        maxMoment = max(maxMoment, m.magnitude());
+        maxMomentErr = max(maxMomentErr, (rational.moment() - m).magnitude());
+        maxFieldErr = max(maxFieldErr, (rational.field() - b).magnitude());
+    }
+
+    double maxAtanErr = 0;
+    mt19937 rng(9);
+    uniform_real_distribution<double> unit(-1.0, 1.0);
+    for (int i = 0; i < 2000000; ++i){
+        double u = unit(rng);
+        double x = i % 3 == 0 ? u : (i % 3 == 1 ? 1e4 * u * u * u
+                                                : 2.4142 + u * 0.5);
+        maxAtanErr = max(maxAtanErr,
+                         fabs(Flatley::rationalAtan(x) - atan(x)));
+    }
+
+    cout << "Tumbling satellite, " << steps << " steps, rods 3/3/0" << endl
+         << "  bank vs previous three Flatleys  : " << mismatches
+         << " mismatches" << endl << scientific << setprecision(2)
+         << "  rational kernel max |dm|         : " << maxMomentErr
+         << " A m^2 (|m| up to " << maxMoment << ")" << endl
+         << "  rational kernel max |dB|         : " << maxFieldErr << " T"
+         << endl
+         << "  rationalAtan max error           : " << maxAtanErr
+         << " rad (rationalError " << Flatley::rationalError << ")" << endl
+         << fixed;
+
+    // A bank of mixed rods: axes scattered about the body axes, PMAC and
+    // the flatley_trial soft iron, a spread of volumes and factors
+    auto mixedBank = [&](size_t n, Flatley::Kernel kernel){
+        HysteresisRodBank bank;
+        mt19937 gen(3);
+        uniform_real_distribution<double> jitter(-0.2, 0.2);
+        for (size_t i = 0; i < n; ++i){
+            HysteresisRod rod;
+            Vector axis = {0, 0, 0};
+            axis[i % 3] = 1;
+            axis = axis + Vector{jitter(gen), jitter(gen), jitter(gen)};
+            rod.axis = axis / axis.magnitude();
+            rod.volume = vol * (1 + jitter(gen));
+            rod.demagFactor = nd * (1 + jitter(gen));
+            bool pmac = i % 2 == 0;
+            rod.loop.hC = pmac ? H_c : 12;
+            rod.loop.bR = pmac ? B_r : 0.004;
+            rod.loop.bS = pmac ? B_s : 0.027;
+            bank.addRod(rod);
+        }
+        bank.setKernel(kernel);
+        return bank;
+    };
+
+    const int repeats = 20;
+    auto time = [&](const string& label, auto& rods, size_t n){
+        bench::Timer timer;
+        for (int r = 0; r < repeats; ++r)
+            for (int i = 0; i < steps; ++i){
+                rods.update(fields[i], attitudes[i]);
+                Vector m = rods.moment();
+                bench::doNotOptimize(m);
+            }
+        double seconds = timer.seconds();
+        bench::report(label, seconds,
+                      static_cast<double>(repeats) * steps, "step");
+        cout << setw(48) << setprecision(2)
+             << seconds / repeats / steps / n * 1e9 << " ns/rod" << endl;
+    };
+
+    struct LegacyStep
+    {
+        LegacyRods& rods;
+        void update(const Vector& H, const array<Vector, 3>& axes)
+        {
+            rods.update(H, axes, 0.1);
+        }
+        Vector moment() const
+        {
+            return {rods.moment[0], rods.moment[1], rods.moment[2]};
+        }
+    } previous{legacy};
+    time("three Flatleys (previous)", previous, 3);
+
+    const pair<Flatley::Kernel, const char*> kernels[] = {
+        {Flatley::Kernel::Exact, "exact"},
+        {Flatley::Kernel::Table, "table"},
+        {Flatley::Kernel::Rational, "rational"}};
+    for (size_t n : {size_t(3), size_t(30), size_t(300)})
+        for (const auto& [kernel, name] : kernels){
+            HysteresisRodBank bank = mixedBank(n, kernel);
+            time("bank, " + to_string(n) + " rods, " + name, bank, n);
+        }
+
+    return mismatches == 0 && maxAtanErr <= Flatley::rationalError ? 0 : 1;
+}
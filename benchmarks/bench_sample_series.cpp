@@ -0,0 +1,121 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "Bench.h"
+#include "Numerics.h"
+#include "SampleSeries.h"
+using namespace std;
+
+// SampleSeries<T, Scheme> in plain storage against SampleDataVector (the
+// same template on FieldStorage), then the cost and accuracy of each
+// compile-time scheme on a smooth synthetic field (60 s cadence, an
+// orbit-like 95 min period), and a quaternion attitude series stored
+// with sign flips.
+
+template <typename Scheme>
+static void runScheme(const char* label, const SampleSeries<Vector>& data,
+                      const DateTime& first, size_t queries, double dt,
+                      double period)
+{
+    // Accuracy against the analytic field
+    double maxErr = 0;
+    SampleCursor at;
+    for (size_t k = 0; k < queries; k += 97){
+        double s = 1800.0 + dt * static_cast<double>(k);
+        Vector v = data.interpolate<Scheme>(first + s, at);
+        double w = 2.0 * M_PI * s / period;
+        Vector exact{cos(w), sin(w), 0.1 * sin(3.0 * w)};
+        maxErr = max(maxErr, (v - exact).magnitude());
+    }
+
+    at = SampleCursor();
+    bench::Timer timer;
+    DateTime t = first + 1800.0;
+    for (size_t k = 0; k < queries; ++k, t = t + dt){
+        Vector v = data.interpolate<Scheme>(t, at);
+        bench::doNotOptimize(v);
+    }
+    bench::report(label, timer.seconds(), static_cast<double>(queries),
+                  "query");
+    cout << "      max error " << scientific << setprecision(2) << maxErr
+         << fixed << endl;
+}
+
+int main()
+{
+    const size_t n = 20000;
+    const double cadence = 60.0, period = 5700.0;
+    DateTime first("01 Oct 2025 00:00:00.000");
+
+    SampleSeries<Vector> series;
+    SampleDataVector field;
+    SampleSeries<Quaternion> attitude;
+    for (size_t i = 0; i < n; ++i){
+        double s = cadence * static_cast<double>(i);
+        double w = 2.0 * M_PI * s / period;
+        Vector v{cos(w), sin(w), 0.1 * sin(3.0 * w)};
+        series.addSample(first + s, v);
+        field.addSample(first + s, v);
+
+        // Spin about z, stored with alternating sign as exports may do
+        double sign = i % 2 ? -1.0 : 1.0;
+        attitude.addSample(first + s, Quaternion(sign * cos(0.5 * w), 0, 0,
+                                                 sign * sin(0.5 * w)));
+    }
+    series.sort();
+    field.sort();
+    attitude.sort();
+
+    const size_t queries = 2000000;
+    const double dt = 0.5;
+
+    // Same results as SampleDataVector, bit for bit: one set of kernels
+    size_t mismatches = 0;
+    SampleCursor at;
+    DateTime t = first + 1800.0;
+    for (size_t k = 0; k < queries; ++k, t = t + dt){
+        Vector a = series.interpolate<Lagrange<4>>(t, at);
+        Vector b = field.lagrangeInterpolate(t);
+        Vector c = series.interpolate<Linear>(t);
+        Vector d = field.linearInterpolate(t);
+        if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2]
+            || c[0] != d[0] || c[1] != d[1] || c[2] != d[2])
+            ++mismatches;
+    }
+    cout << "Mismatches vs SampleDataVector : " << mismatches << endl;
+
+    bench::Timer timer;
+    t = first + 1800.0;
+    for (size_t k = 0; k < queries; ++k, t = t + dt){
+        Vector v = field.lagrangeInterpolate(t);
+        bench::doNotOptimize(v);
+    }
+    bench::report("SampleDataVector, lagrange", timer.seconds(),
+                  static_cast<double>(queries), "query");
+
+    runScheme<Linear>("SampleSeries, Linear", series, first, queries, dt,
+                      period);
+    runScheme<Lagrange<4>>("SampleSeries, Lagrange<4>", series, first,
+                           queries, dt, period);
+    runScheme<Lagrange<6>>("SampleSeries, Lagrange<6>", series, first,
+                           queries, dt, period);
+    runScheme<Lagrange<8>>("SampleSeries, Lagrange<8>", series, first,
+                           queries, dt, period);
+
+    // Attitude: the sign flips are undone by sort(), so the interpolated
+    // rotation stays a unit quaternion about z at the expected angle
+    double maxAngleErr = 0;
+    for (size_t k = 0; k < 100000; ++k){
+        double s = 1800.0 + 0.37 * static_cast<double>(k);
+        Quaternion q = attitude.interpolate(first + s);
+        double angle = 2.0 * atan2(q.z, q.w);
+        double expected = remainder(2.0 * M_PI * s / period, 2.0 * M_PI);
+        maxAngleErr = max(maxAngleErr,
+                          fabs(remainder(angle - expected, 2.0 * M_PI)));
+    }
+    cout << "Quaternion max angle error     : " << scientific
+         << setprecision(2) << maxAngleErr << " rad" << endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
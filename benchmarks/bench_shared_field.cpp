@@ -0,0 +1,91 @@
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "Bench.h"
+#include "Numerics.h"
+using namespace std;
+
+// Several runs over one field series at once: every thread queries the
+// same const SampleDataVector through its own SampleCursor, as parallel
+// simulate() calls do. Reports resident memory before and after starting
+// the runs (a copy per run would add the whole series each time) and
+// checks every thread gets exactly the single-threaded results.
+//
+// Usage: ./bench_shared_field.out [threads] [samples]
+
+static double residentMB()
+{
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1048576.0;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t threads = argc > 1 ? strtoull(argv[1], nullptr, 10) : 8;
+    size_t samples = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+
+    // 10 s cadence, the STK export interval
+    DateTime first("01 Oct 2025 00:00:00.000");
+    SampleDataVector field;
+    for (size_t i = 0; i < samples; ++i){
+        double s = 10.0 * static_cast<double>(i);
+        field.addSample(first + s, {20000.0 * sin(s * 1e-4),
+                                    15000.0 * cos(s * 7e-5),
+                                    -30000.0 + 500.0 * sin(s * 3e-4)});
+    }
+    field.sort();
+    field = field * 7.95e-4;
+    field.buildInterpolant();
+
+    // Each run covers its own day, queried at 0.1 s
+    const size_t queries = 864000;
+    const double dt = 0.1;
+    auto run = [&](const SampleDataVector& data, size_t r, double& sum){
+        SampleCursor at;
+        DateTime t = first + 86400.0 * static_cast<double>(r % 300);
+        sum = 0;
+        for (size_t k = 0; k < queries; ++k, t = t + dt)
+            sum += data.lagrangeInterpolate(t, at)[0];
+    };
+
+    vector<double> expected(threads);
+    bench::Timer timer;
+    for (size_t r = 0; r < threads; ++r)
+        run(field, r, expected[r]);
+    bench::report("sequential runs", timer.seconds(),
+                  static_cast<double>(threads * queries), "query");
+
+    const SampleDataVector& shared = field;
+    vector<double> sums(threads);
+    double before = residentMB();
+    timer.reset();
+    {
+        vector<thread> pool;
+        for (size_t r = 0; r < threads; ++r)
+            pool.emplace_back(run, cref(shared), r, ref(sums[r]));
+        for (thread& th : pool)
+            th.join();
+    }
+    bench::report("concurrent runs, shared", timer.seconds(),
+                  static_cast<double>(threads * queries), "query");
+    double added = residentMB() - before;
+
+    size_t mismatches = 0;
+    for (size_t r = 0; r < threads; ++r)
+        if (sums[r] != expected[r])
+            ++mismatches;
+
+    cout << "Threads              : " << threads << endl;
+    cout << "Series size          : "
+         << samples * 136 / 1048576 << " MB (with interpolant)" << endl;
+    cout << "Memory added by runs : " << added << " MB" << endl;
+    cout << "Mismatches           : " << mismatches << endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
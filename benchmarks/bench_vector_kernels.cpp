@@ -0,0 +1,62 @@
+#include <iostream>
+#include <vector>
+#include "Bench.h"
+#include "Vector.h"
+using namespace std;
+
+// Dot and cross products over arrays of Vectors, the two kernels that
+// dominate the torque and frame transforms. Built twice:
+//   bench_vector_kernels.out          element access unchecked; GCC
+//                                     prints its vectoriser report for
+//                                     these loops while compiling
+//   bench_vector_kernels_checked.out  linked to the checked library
+//                                     (MAGSIMS_BOUNDS_CHECK=1)
+
+__attribute__((noinline))
+static void dotKernel(const Vector* a, const Vector* b, double* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = a[i] * b[i];
+}
+
+__attribute__((noinline))
+static void crossKernel(const Vector* a, const Vector* b, Vector* out,
+                        size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = a[i] ^ b[i];
+}
+
+int main()
+{
+    const size_t n = 4096;
+    const int repeats = 20000;
+
+    vector<Vector> a(n), b(n), cross(n);
+    vector<double> dot(n);
+    for (size_t i = 0; i < n; i++){
+        a[i] = {1.0 + 0.001 * i, 0.5 - 0.002 * i, 0.25 * i};
+        b[i] = {0.3 * i, 1.0 - 0.0001 * i, 2.0};
+    }
+
+    cout << "Bounds checks        : "
+         << (MAGSIMS_BOUNDS_CHECK ? "on" : "off") << endl;
+
+    bench::Timer timer;
+    for (int r = 0; r < repeats; r++){
+        dotKernel(a.data(), b.data(), dot.data(), n);
+        bench::doNotOptimize(dot[0]);
+    }
+    bench::report("dot product", timer.seconds(),
+                  static_cast<double>(n) * repeats, "op");
+
+    timer.reset();
+    for (int r = 0; r < repeats; r++){
+        crossKernel(a.data(), b.data(), cross.data(), n);
+        bench::doNotOptimize(cross[0]);
+    }
+    bench::report("cross product", timer.seconds(),
+                  static_cast<double>(n) * repeats, "op");
+
+    return 0;
+}
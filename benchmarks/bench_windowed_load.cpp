@@ -0,0 +1,110 @@
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "Bench.h"
+#include "Numerics.h"
+using namespace std;
+
+// Full CSV load against the windowed streaming mode of SampleDataVector
+// on a synthetic STK-style export (1 s cadence, default 2M rows, about
+// 23 days). Reports open time, resident memory and interpolation
+// agreement for a 7 h run in the middle of the file, then streams the
+// whole file through the window to show memory stays bounded.
+//
+// Usage: ./bench_windowed_load.out [rows]
+
+static double residentMB()
+{
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1048576.0;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t rows = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+
+    string csvFile = (filesystem::temp_directory_path()
+                      / "bench_windowed_load.csv").string();
+    DateTime first("01 Oct 2025 00:00:00.000");
+    {
+        ofstream out(csvFile);
+        out << "\"Time (UTCG)\",\"x (nT)\",\"y (nT)\",\"z (nT)\"\n";
+        char stamp[DateTime::formatLength];
+        for (size_t i = 0; i < rows; ++i){
+            double s = static_cast<double>(i);
+            out.write(stamp, (first + s).format(stamp));
+            out << ',' << 20000.0 * sin(s * 1e-3)
+                << ',' << 15000.0 * cos(s * 7e-4)
+                << ',' << -30000.0 + 500.0 * sin(s * 3e-3) << '\n';
+        }
+    }
+    cout << "Rows                 : " << rows << " ("
+         << filesystem::file_size(csvFile) / 1048576 << " MB)" << endl;
+
+    const string t = "\"Time (UTCG)\"";
+    const string x = "\"x (nT)\"", y = "\"y (nT)\"", z = "\"z (nT)\"";
+    double span = static_cast<double>(rows - 1);
+    DateTime start = first + 0.5 * span;
+    DateTime stop = start + 7 * 3600.0;
+    const double dt = 0.1;
+
+    /* Windowed: the 7 h run */
+    double rssBefore = residentMB();
+    bench::Timer timer;
+    SampleDataVector windowed = SampleDataVector::openWindow(
+        csvFile, t, {x, y, z}, start, stop);
+    double openSeconds = timer.seconds();
+    double rssWindow = residentMB() - rssBefore;
+
+    vector<Vector> windowedRun;
+    for (DateTime now = start; now < stop; now = now + dt)
+        windowedRun.push_back(windowed.lagrangeInterpolate(now));
+
+    /* Windowed: the whole file, sampling resident memory */
+    double rssPeak = 0;
+    {
+        SampleDataVector all = SampleDataVector::openWindow(
+            csvFile, t, {x, y, z}, first, first + span, 1 << 14);
+        timer.reset();
+        size_t k = 0;
+        for (DateTime now = first; now < first + span; now = now + 1.0){
+            Vector v = all.lagrangeInterpolate(now);
+            bench::doNotOptimize(v);
+            if (++k % 100000 == 0)
+                rssPeak = max(rssPeak, residentMB() - rssBefore);
+        }
+        bench::report("windowed sweep, whole file", timer.seconds(),
+                      static_cast<double>(k), "query");
+    }
+
+    /* Full load */
+    double rssFullBefore = residentMB();
+    timer.reset();
+    SampleDataVector full(csvFile, t, {x, y, z});
+    double fullSeconds = timer.seconds();
+    double rssFull = residentMB() - rssFullBefore;
+
+    double maxDiff = 0;
+    size_t k = 0;
+    for (DateTime now = start; now < stop; now = now + dt)
+        maxDiff = max(maxDiff,
+                      (full.lagrangeInterpolate(now) - windowedRun[k++])
+                      .magnitude());
+
+    cout << "Open, 7 h window     : " << openSeconds * 1e3 << " ms, "
+         << rssWindow << " MB resident" << endl;
+    cout << "Whole-file stream    : " << rssPeak << " MB peak resident"
+         << endl;
+    cout << "Full load            : " << fullSeconds * 1e3 << " ms, "
+         << rssFull << " MB resident" << endl;
+    cout << "Max difference (7 h) : " << maxDiff << endl;
+
+    filesystem::remove(csvFile);
+    return maxDiff == 0 ? 0 : 1;
+}
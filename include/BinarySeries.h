@@ -0,0 +1,74 @@
+#ifndef BINARYSERIES_H
+#define BINARYSERIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+
+/* ================= Binary series file format =================
+
+   Compact on-disk form of a SampleDataVector, designed to be mmap'd and
+   read in place (native byte order, little endian on every platform we
+   run on):
+
+       offset 0            BinarySeriesHeader (64 bytes)
+       timeOffset          int64_t  ticks[count]     ns since Unix epoch
+       valueOffset         double   x[count], y[count], z[count]
+
+   Values are planar (all x, then all y, then all z) so the file maps
+   straight onto the structure-of-arrays layout of SampleDataVector.
+   Both sections start on a 64 byte boundary. Values are stored exactly as
+   read from the source (e.g. nT); unit conversion is applied on load.
+*/
+
+struct BinarySeriesHeader
+{
+    char     magic[8];          // "MAGSBIN1"
+    uint32_t version;           // binarySeriesVersion
+    uint32_t components;        // values per sample (3)
+    uint64_t count;             // number of samples
+    uint64_t timeOffset;        // byte offset of the ticks array
+    uint64_t valueOffset;       // byte offset of the values array
+    uint8_t  sorted;            // 1 if ticks are non-decreasing
+    uint8_t  reserved[7];
+    int64_t  gridStep;          // ticks[i] == ticks[0] + i * gridStep,
+                                // 0 if the sampling is not uniform
+    uint8_t  reserved2[8];
+};
+
+static_assert(sizeof(BinarySeriesHeader) == 64,
+              "BinarySeriesHeader must stay 64 bytes");
+
+constexpr char     binarySeriesMagic[8] = {'M','A','G','S','B','I','N','1'};
+constexpr uint32_t binarySeriesVersion  = 2;     // 1: packed xyz
+
+// Pointers into a mapped binary series file
+struct BinarySeriesView
+{
+    size_t count = 0;
+    const int64_t* ticks = nullptr;
+    const double* x = nullptr;
+    const double* y = nullptr;
+    const double* z = nullptr;
+    bool sorted = false;
+    int64_t gridStep = 0;
+};
+
+// Validates the header of a mapped file and returns views into it
+BinarySeriesView viewBinarySeries(const MappedFile& file);
+
+// true if the file starts with the binary series magic
+bool isBinarySeries(const std::string& filename);
+
+// Writes count samples (ticks and one array per component)
+void writeBinarySeries(const std::string& filename,
+                       size_t count,
+                       const int64_t* ticks,
+                       const double* x,
+                       const double* y,
+                       const double* z,
+                       bool sorted,
+                       int64_t gridStep = 0);
+
+#endif // BINARYSERIES_H
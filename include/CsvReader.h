@@ -0,0 +1,102 @@
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MappedFile;
+
+using std::vector;
+using std::string;
+
+/* ================= CSV ingest =================
+
+   Reader for large STK CSV exports (a time column plus numeric columns).
+   The file is memory-mapped and split into newline-aligned chunks that
+   are parsed in parallel; each row is scanned in place, without building
+   strings or streams, and numbers are parsed with std::from_chars. The
+   chunk results are concatenated in file order.
+*/
+
+struct CsvSeries
+{
+    vector<int64_t> ticks;          // time column, DateTime::ticks()
+    vector<double> values;          // selected columns, row-major
+    size_t columns = 0;             // values per row
+    size_t skipped = 0;             // malformed rows that were dropped
+
+    size_t rows() const { return ticks.size(); }
+};
+
+// Reads timeColumn and valueColumns from every row of filename. Column
+// names must match the header exactly (including any quotes). threads = 0
+// uses every hardware thread.
+CsvSeries readCsvSeries(const string& filename,
+                        const string& timeColumn,
+                        const vector<string>& valueColumns,
+                        unsigned threads = 0);
+
+
+/* ================= Windowed CSV stream =================
+
+   Reads a time-sorted CSV export one block at a time, for files too
+   large to hold in memory. Rows before startTicks are never parsed: the
+   first row is found by binary search over the mapped file. Reading
+   stops shortly after stopTicks. `margin` rows are kept on either side
+   of the range for interpolation stencils (0 keeps the range only). A
+   background thread parses the next block while the caller consumes the
+   current one, and parsed pages are released, so memory stays at about
+   two blocks whatever the file length.
+*/
+
+class CsvStream
+{
+public:
+    CsvStream(const string& filename,
+              const string& timeColumn,
+              const vector<string>& valueColumns,
+              int64_t startTicks,
+              int64_t stopTicks,
+              size_t blockRows = 1 << 16,
+              size_t margin = 3);
+    ~CsvStream();
+
+    CsvStream(const CsvStream&) = delete;
+    CsvStream& operator=(const CsvStream&) = delete;
+
+    // Moves the next block of rows (in file order) into block. Returns
+    // false once the range is exhausted; rethrows a parse-thread error.
+    bool next(CsvSeries& block);
+
+private:
+    void produce();
+
+    std::unique_ptr<MappedFile> file;
+    vector<size_t> wanted;
+    size_t lastWanted = 0;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    int64_t stopTicks;
+    size_t blockRows;
+    size_t margin;
+
+    // One block handed from the parse thread to the caller
+    std::mutex lock;
+    std::condition_variable changed;
+    CsvSeries pending;
+    bool hasPending = false;
+    bool finished = false;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    std::thread worker;
+};
+
+#endif // CSVREADER_H
@@ -3,17 +3,27 @@
 
 #include <string>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 using namespace std;
 
+// Instant in time (UTC). Text uses the STK format
+// "1 Oct 2025 06:30:10.000"; parsing and formatting are hand written,
+// keep sub-second precision and never consult the time-zone database.
 struct DateTime
 {
     // Constructors
     DateTime();
     DateTime(const std::string &time_str);
+    DateTime(const char *time_str, size_t length);
 
     // Accessor
     std::string toString() const;
 
+    // Nanoseconds since the Unix epoch (the on-disk time stamp format)
+    int64_t ticks() const;
+    static DateTime fromTicks(int64_t ticks);
+
     // Comparison operators
     bool operator<(const DateTime &other) const;
     bool operator>(const DateTime &other) const;
@@ -27,11 +37,18 @@ struct DateTime
     // returns time as a string
     string display() const;
 
+    // Writes display() into buffer without allocating, returns the
+    // number of characters written (formatLength, no terminator)
+    static constexpr size_t formatLength = 24;
+    size_t format(char *buffer) const;
+
 private:
     std::chrono::system_clock::time_point tp;
 
+    explicit DateTime(std::chrono::system_clock::time_point t) : tp(t) {}
+
     static std::chrono::system_clock::time_point 
-        parseDateTime(const std::string &time_str);
+        parseDateTime(const char *begin, const char *end);
 };
 
 #endif
@@ -2,24 +2,75 @@
 #define DEBUG_H
 
 #include <string>
+#include <cstddef>
 
+// Range checking of Vector/Matrix element access. The build defines it
+// to 1 for sanitizer builds (ENABLE_SANITIZERS), with ENABLE_BOUNDS_CHECKS
+// and for the magnetic_simulation_lib_checked library; otherwise the
+// checks are compiled out entirely.
+#ifndef MAGSIMS_BOUNDS_CHECK
+#define MAGSIMS_BOUNDS_CHECK 0
+#endif
+
+// Per-thread call stack used to annotate exception messages. Each thread
+// owns a fixed ring of function names (the __func__ literals, so nothing
+// is copied or allocated) and pushing or popping is a store and an
+// increment: no locks, safe to leave on in multi-threaded runs. Frames
+// deeper than the capacity overwrite the oldest ones.
 class CallStackTracker
 {
 public:
-    static void push(const std::string &func);
-    static void pop();
-    static std::string trace();
+    static constexpr size_t capacity = 64;
+
+    static void push(const char *func) noexcept;
+    static void pop() noexcept;
+    static std::string trace();     // stack of the calling thread
+
+private:
+    struct Stack
+    {
+        const char *frames[capacity];
+        size_t depth = 0;
+    };
+
+    static thread_local Stack stack;
 };
 
+inline thread_local CallStackTracker::Stack CallStackTracker::stack;
+
 class CallTracer
 {
 public:
-    CallTracer(const std::string &func);
+    explicit CallTracer(const char *func) noexcept;
     ~CallTracer();
+
+    CallTracer(const CallTracer&) = delete;
+    CallTracer& operator=(const CallTracer&) = delete;
 };
 
+inline void CallStackTracker::push(const char *func) noexcept
+{
+    stack.frames[stack.depth % capacity] = func;
+    ++stack.depth;
+}
+
+inline void CallStackTracker::pop() noexcept
+{
+    if (stack.depth > 0)
+        --stack.depth;
+}
+
+inline CallTracer::CallTracer(const char *func) noexcept
+{
+    CallStackTracker::push(func);
+}
+
+inline CallTracer::~CallTracer()
+{
+    CallStackTracker::pop();
+}
+
 // Use this macro at the beginning of a function to trace it
 #define TRACE_CALL CallTracer tracer(__func__)
 
 #endif // DEBUG_H
-
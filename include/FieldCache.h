@@ -0,0 +1,71 @@
+#ifndef FIELD_CACHE_H
+#define FIELD_CACHE_H
+
+#include <string>
+#include "DateTime.h"
+#include "Numerics.h"
+
+using std::string;
+
+
+/* ================= FieldCache ================= */
+
+// The field a run samples, interpolated once onto the run's own time
+// grid (start, start + timestep, ... past stop, as simulate() steps) and
+// kept in a directory as a binary series file. Entries are keyed by the
+// source file (path, size and modification time, so an edited export is
+// not served stale), its columns, the window and the timestep. Later
+// runs, in this process or any other, map the entry (one copy in the
+// page cache for all of them) instead of parsing and interpolating.
+//
+// On the grid the cached samples are exactly what lagrangeInterpolate()
+// of the source gave, and a lookup there returns them unchanged; between
+// grid points (adaptive steps) they are interpolated again. Values are
+// kept in the source's units, like any binary series file. Entries are
+// written to a temporary file and renamed into place, so a reader never
+// sees a partial one (a failed write removes the temporary file); within
+// a process one thread builds a missing entry while the others asking
+// for it wait, and other entries build alongside.
+class FieldCache
+{
+public:
+    explicit FieldCache(const string& directory);
+
+    // Cached field of the source over the run, built first if missing
+    SampleDataVector field(const string& sourceFile,
+                           const string& timeColumn,
+                           const string& colX,
+                           const string& colY,
+                           const string& colZ,
+                           const DateTime& start,
+                           const DateTime& stop,
+                           double timestep) const;
+
+    // Entry file for these arguments, and whether it exists yet
+    string path(const string& sourceFile,
+                const string& timeColumn,
+                const string& colX,
+                const string& colY,
+                const string& colZ,
+                const DateTime& start,
+                const DateTime& stop,
+                double timestep) const;
+    bool contains(const string& entry) const;
+
+    const string& directory() const;
+
+private:
+    string directory_;
+
+    void build(const string& entry,
+               const string& sourceFile,
+               const string& timeColumn,
+               const string& colX,
+               const string& colY,
+               const string& colZ,
+               const DateTime& start,
+               const DateTime& stop,
+               double timestep) const;
+};
+
+#endif /* FIELD_CACHE_H */
@@ -2,10 +2,46 @@
 #define FLATLEY_H
 
 #include "Vector.h"
+#include "HysteresisModel.h"
 #include <cmath>
 
 class Flatley
 {
+public:
+
+    // How calcMagField evaluates the inverse tangent of the loop
+    enum class Kernel
+    {
+        Exact,      // std::atan
+        Table,      // tableAtan(), B within tableError * 2 bS / pi
+        Rational    // rationalAtan(), B within rationalError * 2 bS / pi
+    };
+
+    // Which model calcMagField follows
+    enum class Form
+    {
+        InverseTangent,     // the active branch at h (no history)
+        Differential        // FlatleyDifferential, adaptive substeps
+    };
+
+    // Largest error of tableAtan() (rad): the cubic Hermite bound
+    // h^4 max|d4 atan / dx4| / 384 with h = 1/256, plus rounding
+    static constexpr double tableError = 2.9e-12;
+
+    // atan from a 256 interval cubic Hermite table on [0, 1] (8 KB,
+    // shared by every parameter set); larger |x| use
+    // atan(x) = pi/2 - atan(1/x)
+    static double tableAtan(double x);
+
+    // Largest error of rationalAtan() (rad), one unit in the last place
+    // of pi/2 (measured, bench_rod_bank)
+    static constexpr double rationalError = 2.3e-16;
+
+    // atan from the Cephes rational approximation with its three range
+    // reductions taken by selects instead of branches, so a loop over
+    // it vectorises (see HysteresisRodBank)
+    static double rationalAtan(double x);
+
 private:
 
     static constexpr double pi = 3.141592653;
@@ -34,6 +70,14 @@ private:
     double tolerance = 0.0f;
     void updateSlopeSign();
 
+    Kernel kernel = Kernel::Exact;
+    Form form = Form::InverseTangent;
+    int substeps = 0;           // of the last differential step
+    double arctan(double x) const;
+
+    // k from the loop parameters (tan(pi bR / 2 bS) / hC)
+    void updateK();
+
 public:
 
     // Constructors
@@ -68,6 +112,8 @@ public:
                        double bSVal,
                        double q0Val,
                        double pVal);
+    void setKernel(Kernel newKernel);
+    void setForm(Form newForm);
 
     // Accessor functions
     double getHC() const;
@@ -82,10 +128,54 @@ public:
                        double& q0Val,
                        double& pVal) const;
     Vector getMagField() const;
+    Kernel getKernel() const;
+    Form getForm() const;
+    // Substeps the last calcMagField took (0 with the inverse tangent)
+    int getSubsteps() const;
+
+    // B (magnitude) on the branch of the loop the field is moving along
+    // (ascending if slopeSign) at auxiliary field h
+    double branchField(double h, bool ascending) const;
 
     // Function to get the magnetic field for next step
     double calcMagField(double timestep, Vector hNew, Vector nNew);
 };
 
+
+inline double Flatley::rationalAtan(double x){
+    const double tan3pi8 = 2.41421356237309504880;
+    const double moreBits = 6.123233995736765886130E-17;
+
+    double a = std::fabs(x);
+    bool large = a > tan3pi8;
+    bool middle = a > 0.66;
+
+    // atan(a) = y + atan(num / den), one select per reduction
+    double num = middle ? a - 1.0 : a;
+    double den = middle ? a + 1.0 : 1.0;
+    double y = middle ? M_PI_4 : 0.0;
+    double extra = middle ? 0.5 * moreBits : 0.0;
+    num = large ? -1.0 : num;
+    den = large ? a : den;
+    y = large ? M_PI_2 : y;
+    extra = large ? moreBits : extra;
+
+    double u = num / den;
+    double z = u * u;
+    double pz = (((-8.750608600031904122785E-1 * z
+                   - 1.615753718733365076637E1) * z
+                  - 7.500855792314704667340E1) * z
+                 - 1.228866684490136173410E2) * z
+                - 6.485021904942025371773E1;
+    double qz = ((((z + 2.485846490142306297962E1) * z
+                   + 1.650270098316988542046E2) * z
+                  + 4.328810604912902668951E2) * z
+                 + 4.853903996359136964868E2) * z
+                + 1.945506571482613964425E2;
+
+    double r = y + ((u * (z * pz / qz) + u) + extra);
+    return std::copysign(r, x);
+}
+
 #endif // FLATLEY_H
 
@@ -0,0 +1,150 @@
+#ifndef GEOMAGNETIC_FIELD_H
+#define GEOMAGNETIC_FIELD_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include "Vector.h"
+#include "DateTime.h"
+#include "SampleSeries.h"
+#include "OrbitPropagator.h"
+
+using std::string;
+
+
+/* ================= GeomagneticField ================= */
+
+// IGRF-style spherical harmonic model of the main field. Evaluates
+// B = -grad V with
+//     V = a sum_n (a/r)^(n+1) sum_m (g_nm cos m phi + h_nm sin m phi) P_nm
+// through the Cartesian recursion for (a/r)^(n+1) P_nm cos/sin m phi
+// (Montenbruck & Gill, sec. 3.2), which has no pole singularity and uses
+// only multiplications, so a batch of positions is evaluated term by
+// term across the batch and vectorises. The recursion constants are
+// computed once and shared; the Schmidt normalisation is folded into
+// the coefficients on load. Coefficients move linearly in time with
+// the secular variation from the model epoch.
+//
+// The built-in coefficients are IGRF-13 (epoch 2020.0, secular variation
+// for 2020-25) to degree 4, about 1% of the field at LEO. Load a full
+// IGRF coefficient table (igrf13coeffs.txt, igrf14coeffs.txt) for
+// degree 13 and a current epoch: a model only covers five years from
+// its epoch, and the built-in one has expired for runs after 2025.
+class GeomagneticField
+{
+public:
+    static constexpr size_t maxDegree = 13;
+    static constexpr double referenceRadius = 6371.2;     // km
+
+    // Built-in IGRF-13 coefficients
+    GeomagneticField();
+
+    // Reads the newest main field and secular variation columns of a
+    // table in the IGRF distribution format
+    explicit GeomagneticField(const string& coefficientFile);
+
+    // The secular variation holds for five years from the epoch (one
+    // IGRF generation); outside them the coefficients are extrapolated
+    DateTime epoch() const;
+    bool covers(const DateTime& t) const;
+
+    size_t degree() const;              // truncation in use
+    size_t availableDegree() const;     // highest degree loaded
+    void setDegree(size_t degree);      // 1 .. availableDegree()
+
+    // Field (nT) at an Earth-fixed position (km)
+    Vector fieldECEF(const Vector& position, const DateTime& t) const;
+
+    // Field (nT) in the inertial frame at an inertial position (km)
+    Vector fieldECI(const Vector& position, const DateTime& t) const;
+
+    // Batch form of fieldECI over count positions in separate x, y, z
+    // arrays. Results match the single-position call exactly.
+    void fieldECI(const DateTime* times, const double* x, const double* y,
+                  const double* z, size_t count,
+                  double* bx, double* by, double* bz) const;
+
+    // Earth rotation angle (rad): the Earth-fixed frame is the inertial
+    // one rotated by this angle about z. Precession and nutation are
+    // neglected (about 0.15 deg by 2025, well below the model error).
+    static double earthRotationAngle(const DateTime& t);
+
+private:
+    // Flattened (n, m) index, n = 0 .. maxDegree + 1
+    static constexpr size_t index(size_t n, size_t m)
+    {
+        return n * (n + 1) / 2 + m;
+    }
+    static constexpr size_t terms = (maxDegree + 2) * (maxDegree + 3) / 2;
+
+    // Unnormalised coefficients (nT) and their rates (nT/year)
+    std::array<double, terms> g{}, h{}, dg{}, dh{};
+    int64_t epochTicks = 0;
+    int64_t validUntilTicks = 0;
+    size_t available = 0;
+    size_t truncation = 0;
+
+    void setEpoch(int year);
+
+    // Converts the Schmidt semi-normalised coefficients read so far
+    void normalise();
+
+    // Field (nT, Earth-fixed axes) at count <= batchChunk positions
+    void evaluate(const double* years, const double* x, const double* y,
+                  const double* z, size_t count,
+                  double* bx, double* by, double* bz) const;
+};
+
+
+/* ================= OrbitField ================= */
+
+// The field along an orbit: the inertial position (km) at the query
+// time, then the model evaluated there. The position comes from a series
+// (such as the STK position export, interpolated) or from an
+// OrbitPropagator, which needs no file at all. Answers at any time,
+// including the integrator's stage times. Queried like SampleDataVector
+// (a SampleCursor per consumer).
+class OrbitField
+{
+public:
+    using PositionSeries = SampleSeries<Vector, Lagrange<8>>;
+
+    OrbitField(const PositionSeries& positions,
+               const GeomagneticField& model = GeomagneticField());
+
+    // Reads "Time (UTCG)" and "Position (x|y|z)" from an STK export
+    OrbitField(const string& positionFile,
+               const GeomagneticField& model = GeomagneticField());
+
+    OrbitField(const OrbitPropagator& orbit,
+               const GeomagneticField& model = GeomagneticField());
+
+    // Field in the inertial frame, in nT times any scale applied
+    Vector field(const DateTime& t) const;
+    Vector field(const DateTime& t, SampleCursor& at) const;
+
+    // Batch form (positions interpolated, then one batched model call)
+    void field(const DateTime* times, size_t count,
+               double* x, double* y, double* z, SampleCursor& at) const;
+
+    // Position at t from whichever source is in use
+    Vector position(const DateTime& t, SampleCursor& at) const;
+
+    bool isPropagated() const;
+    const PositionSeries& positions() const;        // empty if propagated
+    const OrbitPropagator& propagator() const;      // if isPropagated()
+    const GeomagneticField& model() const;
+
+    // Operators (scales the returned field, e.g. nT to A/m)
+    OrbitField operator*(double scalar) const;
+
+private:
+    PositionSeries positions_;
+    std::optional<OrbitPropagator> propagator_;
+    GeomagneticField model_;
+    double scale = 1.0;
+    mutable SampleCursor cursor;
+};
+
+#endif /* GEOMAGNETIC_FIELD_H */
@@ -0,0 +1,341 @@
+#ifndef HYSTERESIS_MODEL_H
+#define HYSTERESIS_MODEL_H
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+static const double mu_0 = 1.257E-6;
+
+
+/* ================= Hysteresis models ================= */
+
+// Compile-time parameters of HysteresisRodBank and Satellite (no virtual
+// calls; the bank's loop over rods inlines the model). A model is a
+// class with
+//
+//   Loop    material parameters of a rod, an aggregate with defaults
+//   Rod     constants derived from a Loop once, by prepare()
+//   State   what a rod carries between steps; value-initialised it is
+//           a demagnetised rod at rest
+//   name    for reports
+//
+//   static Rod prepare(const Loop& loop);
+//   template <typename Atan>
+//   static double step(const Rod& rod, State& state, double h,
+//                      double hPrev, double tolerance, Atan arctan);
+//
+// step() moves the rod from auxiliary field hPrev to h (A/m, along the
+// rod) and returns B (T). Models built on the inverse tangent loop take
+// arctan (one of the Flatley kernels) for it; others ignore it.
+// tolerance is the change in h below which the branch is kept.
+
+// Loop parameters of the Flatley models, as Flatley takes them
+struct FlatleyLoop
+{
+    double hC = 80;     // coercivity (A/m)
+    double bR = 1.3;    // remanence (T)
+    double bS = 2.1;    // saturation (T)
+    double q0 = 0;      // slope ratio at reversal (differential form)
+    double p  = 2;      // exponent of the slope blend (differential form)
+};
+
+// The limiting loop B = (2 bS / pi) atan(k (h -+ hC)) both Flatley
+// models share
+struct FlatleyBranches
+{
+    // Flatley's value, so that a rod matches a Flatley bit for bit
+    static constexpr double pi = 3.141592653;
+
+    double hC;
+    double k;           // tan(pi bR / 2 bS) / hC
+    double scale;       // 2 bS / pi
+
+    static FlatleyBranches of(const FlatleyLoop& loop)
+    {
+        return {loop.hC,
+                std::tan(pi * loop.bR / (2 * loop.bS)) / loop.hC,
+                2 * loop.bS / pi};
+    }
+};
+
+// Branch the field is moving along (1 ascending, 0 descending), as
+// Flatley::updateSlopeSign picks it, by selects rather than branches
+inline double flatleyBranch(double h, double hPrev, double tolerance,
+                            double ascending)
+{
+    double slope = h - hPrev;
+    double rising = slope > tolerance ? 1.0 : ascending;
+    return slope < -tolerance ? 0.0 : rising;
+}
+
+
+/* ================= FlatleyAtan ================= */
+
+// The inverse tangent model Flatley::calcMagField evaluates: B is the
+// active branch of the limiting loop at h, so reversals jump between
+// branches. No history beyond the branch; no loop inside the step, so
+// the bank's pass vectorises with a branch-free arctan.
+struct FlatleyAtan
+{
+    using Loop = FlatleyLoop;
+    using Rod = FlatleyBranches;
+
+    struct State
+    {
+        double ascending = 0;
+    };
+
+    static constexpr const char* name = "Flatley (inverse tangent)";
+
+    static Rod prepare(const Loop& loop)
+    {
+        return FlatleyBranches::of(loop);
+    }
+
+    template <typename Atan>
+    static double step(const Rod& rod, State& state, double h,
+                       double hPrev, double tolerance, Atan arctan)
+    {
+        double rising = flatleyBranch(h, hPrev, tolerance, state.ascending);
+        state.ascending = rising;
+
+        // -hC on the ascending branch, hC on the descending one
+        double offset = rod.hC * (1.0 - 2.0 * rising);
+        return rod.scale * arctan(rod.k * (h + offset));
+    }
+};
+
+
+/* ================= FlatleyDifferential ================= */
+
+// The differential form of the Flatley model (Flatley & Henretty 1995),
+// the block kept in comments in Flatley::calcMagField:
+//     dB/dH = (q0 + (1 - q0) beta^p) (2 k bS / pi) cos^2(pi B / 2 bS)
+// where beta runs from 0 on the branch the field turned away from to 1
+// on the branch it is moving towards, so minor loops close inside the
+// limiting one.
+//
+// Integrated over h by an embedded Heun / Euler pair: a substep is kept
+// when the two differ by at most errorTolerance bS, and the next one is
+// sized from that difference. An unchanged h takes no substep and a
+// small change one; substeps shrink only where the slope turns, about
+// the coercive field. Every value is clamped between the branches, the
+// envelope bMin <= B <= bMax at that h.
+struct FlatleyDifferential
+{
+    using Loop = FlatleyLoop;
+
+    static constexpr double errorTolerance = 1e-5;  // per substep, of bS
+    static constexpr int maxSubsteps = 1000;
+
+    struct Rod
+    {
+        FlatleyBranches branches;
+        double q0;
+        double p;
+        double slope;       // 2 k bS / pi, the branch slope at its centre
+        double bTolerance;  // errorTolerance bS (T)
+    };
+
+    struct State
+    {
+        double ascending = 0;
+        double b = 0;
+        int substeps = 0;   // kept in the last step
+        int rejected = 0;   // tried and refined in the last step
+    };
+
+    static constexpr const char* name = "Flatley (differential)";
+
+    static Rod prepare(const Loop& loop)
+    {
+        FlatleyBranches branches = FlatleyBranches::of(loop);
+        return {branches, loop.q0, loop.p, branches.k * branches.scale,
+                errorTolerance * loop.bS};
+    }
+
+    // dB/dh at (h, b) on the branch given by rising
+    static double slopeAt(const Rod& rod, double rising, double h, double b)
+    {
+        const FlatleyBranches& br = rod.branches;
+
+        // Centre of the loop at the present B, and where h sits across it
+        double t = std::tan(b / br.scale);
+        double centre = t / br.k;
+        double across = rising != 0.0
+                      ? (h - centre + br.hC) / (2 * br.hC)
+                      : (centre + br.hC - h) / (2 * br.hC);
+        across = std::fmin(std::fmax(across, 0.0), 1.0);
+        double beta = rod.p == 2 ? across * across : std::pow(across, rod.p);
+
+        double cos2 = 1.0 / (1.0 + t * t);
+        return (rod.q0 + (1 - rod.q0) * beta) * rod.slope * cos2;
+    }
+
+    // b held between the branches at h
+    template <typename Atan>
+    static double envelope(const FlatleyBranches& br, double h, double b,
+                           Atan arctan)
+    {
+        double bMax = br.scale * arctan(br.k * (h + br.hC));
+        double bMin = br.scale * arctan(br.k * (h - br.hC));
+        return std::fmin(std::fmax(b, bMin), bMax);
+    }
+
+    template <typename Atan>
+    static double step(const Rod& rod, State& state, double h,
+                       double hPrev, double tolerance, Atan arctan)
+    {
+        const FlatleyBranches& br = rod.branches;
+        double rising = flatleyBranch(h, hPrev, tolerance, state.ascending);
+        state.ascending = rising;
+        state.substeps = 0;
+        state.rejected = 0;
+
+        // hs would never reach a non-finite h: no value to clamp to
+        if (!std::isfinite(h - hPrev)){
+            state.b = std::numeric_limits<double>::quiet_NaN();
+            return state.b;
+        }
+
+        // Every try, kept or not, counts against maxSubsteps
+        double b = state.b;
+        double hs = hPrev;
+        double dh = h - hPrev;      // first try the whole way
+        while (hs != h){
+            double remaining = h - hs;
+            bool last = std::fabs(dh) >= std::fabs(remaining)
+                     || state.substeps + state.rejected + 1 >= maxSubsteps;
+            if (last)
+                dh = remaining;
+            double hNext = last ? h : hs + dh;
+
+            double k1 = slopeAt(rod, rising, hs, b);
+            double bEuler = envelope(br, hNext, b + dh * k1, arctan);
+            double k2 = slopeAt(rod, rising, hNext, bEuler);
+            double error = 0.5 * std::fabs(dh * (k2 - k1));
+
+            bool keep = error <= rod.bTolerance
+                     || state.substeps + state.rejected + 1 >= maxSubsteps;
+            if (keep){
+                b = envelope(br, hNext, b + 0.5 * dh * (k1 + k2), arctan);
+                hs = hNext;
+                state.substeps++;
+            } else {
+                state.rejected++;
+            }
+
+            // Second order: the error goes as dh^2
+            double grow = error > 0
+                        ? 0.9 * std::sqrt(rod.bTolerance / error) : 4.0;
+            dh *= std::fmin(std::fmax(grow, 0.2), 4.0);
+        }
+        state.b = b;
+        return b;
+    }
+};
+
+
+/* ================= JilesAtherton ================= */
+
+// Jiles-Atherton model (Jiles & Atherton 1986): the magnetisation splits
+// into a reversible part following the anhysteretic curve
+//     Man = Ms (coth(He / a) - a / He),   He = H + alpha M
+// and an irreversible part pinned by k,
+//     dMirr/dH = (Man - Mirr) / (delta k - alpha (Man - Mirr))
+// (delta the sign of dH; no change while it would move away from Man),
+// with M = c Man + (1 - c) Mirr and B = mu_0 (H + M). Integrated with
+// forward Euler over substeps no longer than a / 4 each, so the count
+// follows how far h moved.
+struct JilesAthertonLoop
+{
+    double mS = 5.8e5;      // saturation magnetisation (A/m), 0.73 T
+    double a = 3.0;         // anhysteretic shape (A/m)
+    double alpha = 1e-6;    // domain coupling
+    double k = 1.6;         // pinning (A/m), about the coercivity
+    double c = 0.1;         // reversible fraction
+};
+
+struct JilesAtherton
+{
+    using Loop = JilesAthertonLoop;
+    using Rod = JilesAthertonLoop;
+
+    static constexpr int maxSubsteps = 1000;
+
+    struct State
+    {
+        double m = 0;       // M (A/m)
+        double mIrr = 0;    // irreversible part (A/m)
+    };
+
+    static constexpr const char* name = "Jiles-Atherton";
+
+    static Rod prepare(const Loop& loop)
+    {
+        return loop;
+    }
+
+    // Langevin function coth x - 1/x, by its series near 0
+    static double langevin(double x)
+    {
+        if (std::fabs(x) < 1e-4)
+            return x / 3 - x * x * x / 45;
+        return 1.0 / std::tanh(x) - 1.0 / x;
+    }
+
+    template <typename Atan>
+    static double step(const Rod& rod, State& state, double h,
+                       double hPrev, double tolerance, Atan arctan)
+    {
+        (void)tolerance;
+        (void)arctan;
+
+        double change = h - hPrev;
+        double delta = change < 0 ? -1.0 : 1.0;
+        int n = static_cast<int>(
+            std::fmin(std::ceil(std::fabs(change) / (0.25 * rod.a)),
+                      maxSubsteps));
+        if (n < 1)
+            n = 1;
+        double dh = change / n;
+
+        // Each substep takes Man at its end, with the M it started from
+        double m = state.m, mIrr = state.mIrr;
+        for (int i = 1; i <= n; i++){
+            double hs = hPrev + dh * i;
+            double mAn = rod.mS * langevin((hs + rod.alpha * m) / rod.a);
+
+            double diff = mAn - mIrr;
+            double dIrr = diff * delta > 0
+                        ? diff / (delta * rod.k - rod.alpha * diff) : 0.0;
+            mIrr += dIrr * dh;
+            m = rod.c * mAn + (1 - rod.c) * mIrr;
+        }
+        state.m = m;
+        state.mIrr = mIrr;
+        return mu_0 * (h + m);
+    }
+};
+
+
+/* ================= Model check ================= */
+
+// Whether M has the members above (used by static_assert)
+template <typename M, typename = void>
+struct IsHysteresisModel : std::false_type {};
+
+template <typename M>
+struct IsHysteresisModel<M, std::void_t<
+    typename M::Loop,
+    typename M::Rod,
+    typename M::State,
+    decltype(M::name),
+    decltype(M::prepare(std::declval<const typename M::Loop&>())),
+    decltype(M::step(std::declval<const typename M::Rod&>(),
+                     std::declval<typename M::State&>(),
+                     0.0, 0.0, 0.0, static_cast<double (*)(double)>(nullptr)))
+>> : std::true_type {};
+
+#endif /* HYSTERESIS_MODEL_H */
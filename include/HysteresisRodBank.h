@@ -0,0 +1,132 @@
+#ifndef HYSTERESIS_ROD_BANK_H
+#define HYSTERESIS_ROD_BANK_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "Vector.h"
+#include "Flatley.h"
+#include "HysteresisModel.h"
+
+using std::array;
+using std::vector;
+
+
+/* ================= HysteresisRod ================= */
+
+// One rod, or count identical rods, of a satellite. The axis is in the
+// body frame; the loop is the Model's (see HysteresisModel.h).
+template <typename Model>
+struct BasicHysteresisRod
+{
+    Vector axis = {1, 0, 0};    // body frame, unit length
+    double volume = 1.0;        // m^3
+    double demagFactor = 30;    // Nd
+    typename Model::Loop loop;
+    int count = 1;              // identical rods this entry stands for
+};
+
+using HysteresisRod = BasicHysteresisRod<FlatleyAtan>;
+
+
+/* ================= HysteresisRodBank ================= */
+
+// Any number of rods, each with its own axis, volume, demagnetisation
+// factor and loop, kept as structure of arrays. update() moves every rod
+// along its loop in one pass over the arrays: the field along the axis,
+// B from the Model's step and the rod's moment
+//     m = count volume (B / mu_0 - h) / (1 - Nd)
+// The Model is a template parameter, so its step is inlined into the
+// pass. For FlatleyAtan the pass has no branches; with
+// Flatley::Kernel::Rational the whole of it vectorises, the other
+// kernels call their atan once per rod.
+//
+// Rods whose axis and parameters agree give the same B, so count keeps
+// a stack of identical rods at the cost of one.
+//
+// The definitions are in HysteresisRodBank.tpp, instantiated for the
+// models of HysteresisModel.h in HysteresisRodBank.cpp (built so that
+// the pass vectorises); include the .tpp to use another model.
+template <typename Model>
+class BasicHysteresisRodBank
+{
+    static_assert(IsHysteresisModel<Model>::value,
+                  "Model lacks the members of a hysteresis model");
+
+public:
+    using Loop = typename Model::Loop;
+    using Rod = BasicHysteresisRod<Model>;
+
+    BasicHysteresisRodBank();
+
+    // Appends a rod (at rest) and returns its index
+    size_t addRod(const Rod& rod);
+    void clear();
+
+    size_t size() const;
+    Rod rod(size_t i) const;
+
+    void setCount(size_t i, int count);
+    void setLoop(size_t i, const Loop& loop);
+    void setKernel(Flatley::Kernel kernel);
+    Flatley::Kernel getKernel() const;
+    void setTolerance(double tolerance);
+
+    // Moves every rod on for the auxiliary field H (A/m, inertial) with
+    // the body axes (inertial) given as {x, y, z}
+    void update(const Vector& H, const array<Vector, 3>& axes);
+
+    // Sum of the rod moments, body frame components (A m^2)
+    Vector moment() const;
+
+    // The moment update(H, axes) would give, leaving every rod as it is
+    // (for integrator stages between updates)
+    Vector momentAt(const Vector& H, const array<Vector, 3>& axes) const;
+
+    // Likewise the field() it would give, along the axes given
+    Vector fieldAt(const Vector& H, const array<Vector, 3>& axes) const;
+
+    // Sum of the rods' B along their axes (T, inertial), with the axes
+    // of the last update()
+    Vector field() const;
+
+    // B (T) and moment (A m^2) of rod i from the last update()
+    double rodField(size_t i) const;
+    double rodMoment(size_t i) const;
+
+private:
+    // Rod description
+    vector<double> axisX, axisY, axisZ;
+    vector<double> volume, demagFactor;
+    vector<int> count;
+    vector<Loop> loops;
+
+    // Derived per rod: the Model's constants, count volume and 1 - Nd
+    vector<typename Model::Rod> constants;
+    vector<double> weight, denominator;
+    void updateDerived(size_t i);
+
+    // State: previous h, the Model's state, B and m
+    vector<double> hPrev, b, m;
+    vector<typename Model::State> states;
+
+    // B and moments of momentAt() and fieldAt(), kept to avoid
+    // allocating per call
+    mutable vector<double> probeB, probeM;
+    void probeAll(const Vector& H, const array<Vector, 3>& axes) const;
+    Vector sumMoments(const vector<double>& moments) const;
+
+    Flatley::Kernel kernel = Flatley::Kernel::Exact;
+    double tolerance = 0.0;
+
+    array<Vector, 3> lastAxes;
+    Vector total = {0, 0, 0};
+};
+
+using HysteresisRodBank = BasicHysteresisRodBank<FlatleyAtan>;
+
+extern template class BasicHysteresisRodBank<FlatleyAtan>;
+extern template class BasicHysteresisRodBank<FlatleyDifferential>;
+extern template class BasicHysteresisRodBank<JilesAtherton>;
+
+#endif /* HYSTERESIS_ROD_BANK_H */
@@ -0,0 +1,318 @@
+// HysteresisRodBank.tpp -- definitions of BasicHysteresisRodBank; see
+// HysteresisRodBank.h for where it is included
+
+#include <cmath>
+
+#if defined(__GNUC__)
+#define RODBANK_NOINLINE __attribute__((noinline))
+#else
+#define RODBANK_NOINLINE
+#endif
+
+
+/* ================= Update pass ================= */
+
+namespace rodbank
+{
+    // The update pass over n rods. The arrays never overlap; said with
+    // __restrict, as this many of them is past the vectoriser's runtime
+    // overlap checks. Kept out of line: inlined into update() the
+    // parameters lose it and GCC no longer vectorises the pass
+    template <typename Model, typename Atan>
+    RODBANK_NOINLINE
+    void sweep(size_t n, double hx, double hy, double hz, double tolerance,
+               const double* __restrict ax,
+               const double* __restrict ay,
+               const double* __restrict az,
+               const typename Model::Rod* __restrict constants,
+               const double* __restrict weight,
+               const double* __restrict denominator,
+               typename Model::State* __restrict states,
+               double* __restrict hPrev,
+               double* __restrict b,
+               double* __restrict m,
+               Atan arctan)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            double h = ax[i] * hx + ay[i] * hy + az[i] * hz;
+            double field = Model::step(constants[i], states[i], h, hPrev[i],
+                                       tolerance, arctan);
+            hPrev[i] = h;
+            b[i] = field;
+            m[i] = weight[i] * (field / mu_0 - h) / denominator[i];
+        }
+    }
+
+    // The same pass from read-only state: each rod steps a copy of its
+    // state, only B and the moments are written
+    template <typename Model, typename Atan>
+    RODBANK_NOINLINE
+    void probe(size_t n, double hx, double hy, double hz, double tolerance,
+               const double* __restrict ax,
+               const double* __restrict ay,
+               const double* __restrict az,
+               const typename Model::Rod* __restrict constants,
+               const double* __restrict weight,
+               const double* __restrict denominator,
+               const typename Model::State* __restrict states,
+               const double* __restrict hPrev,
+               double* __restrict b,
+               double* __restrict m,
+               Atan arctan)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            double h = ax[i] * hx + ay[i] * hy + az[i] * hz;
+            typename Model::State state = states[i];
+            double field = Model::step(constants[i], state, h, hPrev[i],
+                                       tolerance, arctan);
+            b[i] = field;
+            m[i] = weight[i] * (field / mu_0 - h) / denominator[i];
+        }
+    }
+}
+
+
+/* ================= BasicHysteresisRodBank ================= */
+
+template <typename Model>
+BasicHysteresisRodBank<Model>::BasicHysteresisRodBank()
+    : lastAxes{Vector{1, 0, 0}, Vector{0, 1, 0}, Vector{0, 0, 1}}
+{
+}
+
+template <typename Model>
+size_t BasicHysteresisRodBank<Model>::addRod(const Rod& rod)
+{
+    axisX.push_back(rod.axis[0]);
+    axisY.push_back(rod.axis[1]);
+    axisZ.push_back(rod.axis[2]);
+    volume.push_back(rod.volume);
+    demagFactor.push_back(rod.demagFactor);
+    count.push_back(rod.count);
+    loops.push_back(rod.loop);
+
+    constants.emplace_back();
+    weight.push_back(0);
+    denominator.push_back(0);
+
+    hPrev.push_back(0);
+    b.push_back(0);
+    m.push_back(0);
+    probeB.push_back(0);
+    probeM.push_back(0);
+    states.emplace_back();
+
+    size_t i = size() - 1;
+    updateDerived(i);
+    return i;
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::clear()
+{
+    for (vector<double>* column : {&axisX, &axisY, &axisZ, &volume,
+                                   &demagFactor, &weight, &denominator,
+                                   &hPrev, &b, &m, &probeB, &probeM})
+        column->clear();
+    count.clear();
+    loops.clear();
+    constants.clear();
+    states.clear();
+    total = {0, 0, 0};
+}
+
+template <typename Model>
+size_t BasicHysteresisRodBank<Model>::size() const
+{
+    return count.size();
+}
+
+template <typename Model>
+typename BasicHysteresisRodBank<Model>::Rod
+BasicHysteresisRodBank<Model>::rod(size_t i) const
+{
+    Rod r;
+    r.axis = {axisX.at(i), axisY[i], axisZ[i]};
+    r.volume = volume[i];
+    r.demagFactor = demagFactor[i];
+    r.loop = loops[i];
+    r.count = count[i];
+    return r;
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::setCount(size_t i, int n)
+{
+    count.at(i) = n;
+    updateDerived(i);
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::setLoop(size_t i, const Loop& loop)
+{
+    loops.at(i) = loop;
+    updateDerived(i);
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::setKernel(Flatley::Kernel newKernel)
+{
+    kernel = newKernel;
+}
+
+template <typename Model>
+Flatley::Kernel BasicHysteresisRodBank<Model>::getKernel() const
+{
+    return kernel;
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::setTolerance(double newTolerance)
+{
+    tolerance = newTolerance;
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::updateDerived(size_t i)
+{
+    // As Satellite::updateHystM evaluated them
+    constants[i] = Model::prepare(loops[i]);
+    weight[i] = count[i] * volume[i];
+    denominator[i] = 1 - demagFactor[i];
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::update(const Vector& H,
+                                           const array<Vector, 3>& axes)
+{
+    // The field in body components; along an axis aligned rod h is
+    // exactly H * axis
+    double hx = H * axes[0];
+    double hy = H * axes[1];
+    double hz = H * axes[2];
+
+    auto sweep = [&](auto arctan){
+        rodbank::sweep<Model>(size(), hx, hy, hz, tolerance,
+                              axisX.data(), axisY.data(), axisZ.data(),
+                              constants.data(), weight.data(),
+                              denominator.data(), states.data(),
+                              hPrev.data(), b.data(), m.data(), arctan);
+    };
+    switch (kernel)
+    {
+    case Flatley::Kernel::Table:
+        sweep([](double x){ return Flatley::tableAtan(x); });
+        break;
+    case Flatley::Kernel::Rational:
+        sweep([](double x){ return Flatley::rationalAtan(x); });
+        break;
+    default:
+        sweep([](double x){ return std::atan(x); });
+    }
+
+    total = sumMoments(m);
+    lastAxes = axes;
+}
+
+template <typename Model>
+void BasicHysteresisRodBank<Model>::probeAll(
+    const Vector& H, const array<Vector, 3>& axes) const
+{
+    double hx = H * axes[0];
+    double hy = H * axes[1];
+    double hz = H * axes[2];
+
+    auto probe = [&](auto arctan){
+        rodbank::probe<Model>(size(), hx, hy, hz, tolerance,
+                              axisX.data(), axisY.data(), axisZ.data(),
+                              constants.data(), weight.data(),
+                              denominator.data(), states.data(),
+                              hPrev.data(), probeB.data(), probeM.data(),
+                              arctan);
+    };
+    switch (kernel)
+    {
+    case Flatley::Kernel::Table:
+        probe([](double x){ return Flatley::tableAtan(x); });
+        break;
+    case Flatley::Kernel::Rational:
+        probe([](double x){ return Flatley::rationalAtan(x); });
+        break;
+    default:
+        probe([](double x){ return std::atan(x); });
+    }
+}
+
+template <typename Model>
+Vector BasicHysteresisRodBank<Model>::momentAt(
+    const Vector& H, const array<Vector, 3>& axes) const
+{
+    probeAll(H, axes);
+    return sumMoments(probeM);
+}
+
+template <typename Model>
+Vector BasicHysteresisRodBank<Model>::fieldAt(
+    const Vector& H, const array<Vector, 3>& axes) const
+{
+    probeAll(H, axes);
+    Vector sum = {0, 0, 0};
+    for (size_t i = 0; i < size(); ++i)
+    {
+        Vector axis = axes[0] * axisX[i] + axes[1] * axisY[i]
+                    + axes[2] * axisZ[i];
+        sum += axis * probeB[i];
+    }
+    return sum;
+}
+
+template <typename Model>
+Vector BasicHysteresisRodBank<Model>::sumMoments(
+    const vector<double>& moments) const
+{
+    // In rod order
+    double mx = 0, my = 0, mz = 0;
+    size_t n = size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        mx += moments[i] * axisX[i];
+        my += moments[i] * axisY[i];
+        mz += moments[i] * axisZ[i];
+    }
+    return {mx, my, mz};
+}
+
+template <typename Model>
+Vector BasicHysteresisRodBank<Model>::moment() const
+{
+    return total;
+}
+
+template <typename Model>
+Vector BasicHysteresisRodBank<Model>::field() const
+{
+    Vector sum = {0, 0, 0};
+    for (size_t i = 0; i < size(); ++i)
+    {
+        Vector axis = lastAxes[0] * axisX[i] + lastAxes[1] * axisY[i]
+                    + lastAxes[2] * axisZ[i];
+        sum += axis * b[i];
+    }
+    return sum;
+}
+
+template <typename Model>
+double BasicHysteresisRodBank<Model>::rodField(size_t i) const
+{
+    return b.at(i);
+}
+
+template <typename Model>
+double BasicHysteresisRodBank<Model>::rodMoment(size_t i) const
+{
+    return m.at(i);
+}
+
+#undef RODBANK_NOINLINE
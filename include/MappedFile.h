@@ -0,0 +1,40 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only memory mapping of a whole file. The pages belong to the OS
+// page cache, so every process mapping the same file shares one copy and
+// nothing is read until it is touched. On platforms without mmap the
+// file is read into a private buffer instead.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const;
+    size_t size() const;
+    const std::string& name() const;
+
+    // Tells the OS the bytes [offset, offset + bytes) will not be read
+    // again, so their pages leave this process's resident set (whole
+    // pages only; no-op without mmap). The data stays readable.
+    void release(size_t offset, size_t bytes) const;
+
+private:
+    std::string filename;
+    const char* begin = nullptr;
+    size_t length = 0;
+
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+};
+
+#endif // MAPPEDFILE_H
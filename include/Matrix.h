@@ -1,49 +1,333 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
-#include <vector>
+#include <array>
 #include <cstddef>
 #include <string>
+#include <initializer_list>
+#include <type_traits>
 #include "Vector.h"  // forward declaration or full include if needed
 using namespace std;
 
-class Matrix
+class Matrix;
+
+// Matrix sums and scalings are lazy in the same way as the Vector ones
+// (see Vector.h): they are evaluated in a single pass when assigned to a
+// Matrix. Products are evaluated eagerly since each element reads a whole
+// row/column of the operands.
+template <typename E>
+class MatrixExpr
+{
+public:
+    constexpr const E& derived() const
+    {
+        return static_cast<const E&>(*this);
+    }
+
+    // Evaluates the expression into a concrete Matrix
+    constexpr Matrix eval() const;
+};
+
+template <typename E>
+struct MatrixOperand { using type = E; };
+
+template <>
+struct MatrixOperand<Matrix> { using type = const Matrix&; };
+
+template <typename E>
+using MatrixOperandT = typename MatrixOperand<E>::type;
+
+
+// Fixed size 3x3 matrix stored row-major in an inline array. Like
+// Vector, it never touches the heap and is trivially copyable.
+class Matrix : public MatrixExpr<Matrix>
 {
 public:
 
     // Constructors
-    Matrix();
-    Matrix(std::initializer_list<double> values);
+    constexpr Matrix() = default;
+    constexpr Matrix(std::initializer_list<double> values);
+    template <typename E>
+    constexpr Matrix(const MatrixExpr<E>& expr);
+
+    template <typename E>
+    constexpr Matrix& operator=(const MatrixExpr<E>& expr);
 
     // Operators to fetch the values at a particular position
-    double& operator()(size_t row, size_t col);
-    const double& operator()(size_t row, size_t col) const;
+    constexpr double& operator()(size_t row, size_t col);
+    constexpr const double& operator()(size_t row, size_t col) const;
 
     // Function to return value 0-9
-    double at(size_t index) const;
-    size_t size() const;
+    constexpr double at(size_t index) const;
+    constexpr size_t size() const;
+
+    // Unchecked row-major element, used by the expression nodes
+    constexpr double coeff(size_t index) const { return data[index]; }
 
     // Function to return the string to display the matrix
     std::string display() const;
 
-    // Operators for matrix multiplication
-    Vector operator*(const Vector& vec) const;
-    Matrix operator*(const Matrix& other) const;
-    Matrix operator+(const Matrix& other) const;
-    Matrix& operator+=(const Matrix& other);
+    // Operators for matrix multiplication (m * s, m + n are free
+    // functions below)
+    template <typename E>
+    constexpr Vector operator*(const VectorExpr<E>& vec) const;
+    constexpr Matrix operator*(const Matrix& other) const;
+    template <typename E>
+    constexpr Matrix& operator+=(const MatrixExpr<E>& other);
 
     // Function to return characteresic values of matrices
-    double determinant() const;
-    Matrix transpose() const;
-    Matrix adjoint() const;
-    Matrix inverse() const;
+    constexpr double determinant() const;
+    constexpr Matrix transpose() const;
+    constexpr Matrix adjoint() const;
+    constexpr Matrix inverse() const;
+
+    // true if every off-diagonal element is within relTol of the
+    // largest diagonal magnitude
+    bool isDiagonal(double relTol = 1e-12) const;
 
 private:
 
-    void checkBounds(size_t row, size_t col) const;
+    constexpr void checkBounds(size_t row, size_t col) const;
 
-    vector<double> data;
+    // Error paths are kept out of line so the hot accessors stay small
+    [[noreturn]] static void throwOutOfRange();
+    [[noreturn]] static void throwBadSize();
+    [[noreturn]] static void throwSingular();
+
+    array<double, 9> data{};
 };
 
-#endif // MATRIX_H
 
+// -- -- -- -- -- - //
+// EXPRESSION NODES //
+// -- -- -- -- -- - //
+
+template <typename L, typename R>
+class MatrixSum : public MatrixExpr<MatrixSum<L, R>>
+{
+public:
+    constexpr MatrixSum(const L& lhs, const R& rhs) : lhs(lhs), rhs(rhs) {}
+    constexpr double coeff(size_t i) const
+    {
+        return lhs.coeff(i) + rhs.coeff(i);
+    }
+
+private:
+    MatrixOperandT<L> lhs;
+    MatrixOperandT<R> rhs;
+};
+
+template <typename E>
+class MatrixScaled : public MatrixExpr<MatrixScaled<E>>
+{
+public:
+    constexpr MatrixScaled(const E& expr, double scalar)
+        : expr(expr), scalar(scalar) {}
+    constexpr double coeff(size_t i) const { return expr.coeff(i) * scalar; }
+
+private:
+    MatrixOperandT<E> expr;
+    double scalar;
+};
+
+template <typename L, typename R>
+constexpr MatrixSum<L, R> operator+(const MatrixExpr<L>& lhs,
+                                    const MatrixExpr<R>& rhs)
+{
+    return MatrixSum<L, R>(lhs.derived(), rhs.derived());
+}
+
+template <typename E>
+constexpr MatrixScaled<E> operator*(const MatrixExpr<E>& expr, double scalar)
+{
+    return MatrixScaled<E>(expr.derived(), scalar);
+}
+
+template <typename E>
+constexpr MatrixScaled<E> operator*(double scalar, const MatrixExpr<E>& expr)
+{
+    return MatrixScaled<E>(expr.derived(), scalar);
+}
+
+
+constexpr Matrix::Matrix(initializer_list<double> values)
+{
+    if (values.size() != 9)
+        throwBadSize();
+
+    size_t index = 0;
+    for (double value : values)
+        data[index++] = value;
+}
+
+
+template <typename E>
+constexpr Matrix::Matrix(const MatrixExpr<E>& expr)
+{
+    const E& e = expr.derived();
+    for (size_t i = 0; i < 9; ++i)
+        data[i] = e.coeff(i);
+}
+
+
+template <typename E>
+constexpr Matrix& Matrix::operator=(const MatrixExpr<E>& expr)
+{
+    const Matrix result(expr);
+    data = result.data;
+    return *this;
+}
+
+
+// operator() is range checked only under MAGSIMS_BOUNDS_CHECK (see
+// Debug.h); at() always is
+constexpr double& Matrix::operator()(size_t row, size_t col)
+{
+#if MAGSIMS_BOUNDS_CHECK
+    checkBounds(row, col);
+#endif
+    return data[row * 3 + col];
+}
+
+
+constexpr const double& Matrix::operator()(size_t row, size_t col) const
+{
+#if MAGSIMS_BOUNDS_CHECK
+    checkBounds(row, col);
+#endif
+    return data[row * 3 + col];
+}
+
+
+constexpr double Matrix::at(size_t index) const
+{
+    if (index >= 9)
+        throwOutOfRange();
+
+    return data[index];
+}
+
+
+constexpr size_t Matrix::size() const
+{
+    return 9;
+}
+
+
+constexpr void Matrix::checkBounds(size_t row, size_t col) const
+{
+    if (row >= 3 || col >= 3)
+        throwOutOfRange();
+}
+
+
+template <typename E>
+constexpr Vector Matrix::operator*(const VectorExpr<E>& expr) const
+{
+    const Vector vec = expr.derived();
+    return Vector{
+        data[0] * vec[0] + data[1] * vec[1] + data[2] * vec[2],
+        data[3] * vec[0] + data[4] * vec[1] + data[5] * vec[2],
+        data[6] * vec[0] + data[7] * vec[1] + data[8] * vec[2]
+    };
+}
+
+
+constexpr Matrix Matrix::operator*(const Matrix& other) const
+{
+    Matrix result;
+
+    for (int row = 0; row < 3; ++row)
+        for (int col = 0; col < 3; ++col)
+        {
+            double sum = 0.0;
+            for (int k = 0; k < 3; ++k)
+                sum += data[3 * row + k] * other.data[3 * k + col];
+
+            result.data[3 * row + col] = sum;
+        }
+
+    return result;
+}
+
+
+template <typename E>
+constexpr Matrix& Matrix::operator+=(const MatrixExpr<E>& other)
+{
+    const Matrix rhs(other);
+    for (size_t i = 0; i < 9; ++i)
+        data[i] += rhs.data[i];
+
+    return *this;
+}
+
+
+constexpr double Matrix::determinant() const
+{
+    double a = data[0], b = data[1], c = data[2];
+    double d = data[3], e = data[4], f = data[5];
+    double g = data[6], h = data[7], i = data[8];
+
+    return a * (e * i - f * h)
+         - b * (d * i - f * g)
+         + c * (d * h - e * g);
+}
+
+
+constexpr Matrix Matrix::transpose() const
+{
+    Matrix result;
+
+    for (size_t row = 0; row < 3; ++row)
+        for (size_t col = 0; col < 3; ++col)
+            result.data[col * 3 + row] = data[row * 3 + col];
+
+    return result;
+}
+
+
+constexpr Matrix Matrix::adjoint() const
+{
+    const Matrix& m = *this;
+    Matrix cof;
+
+    cof(0, 0) =  m(1,1) * m(2,2) - m(1,2) * m(2,1);
+    cof(0, 1) = -(m(1,0) * m(2,2) - m(1,2) * m(2,0));
+    cof(0, 2) =  m(1,0) * m(2,1) - m(1,1) * m(2,0);
+
+    cof(1, 0) = -(m(0,1) * m(2,2) - m(0,2) * m(2,1));
+    cof(1, 1) =  m(0,0) * m(2,2) - m(0,2) * m(2,0);
+    cof(1, 2) = -(m(0,0) * m(2,1) - m(0,1) * m(2,0));
+
+    cof(2, 0) =  m(0,1) * m(1,2) - m(0,2) * m(1,1);
+    cof(2, 1) = -(m(0,0) * m(1,2) - m(0,2) * m(1,0));
+    cof(2, 2) =  m(0,0) * m(1,1) - m(0,1) * m(1,0);
+
+    return cof.transpose();
+}
+
+
+constexpr Matrix Matrix::inverse() const
+{
+    double det = determinant();
+    Matrix adj = adjoint();
+
+    if (det == 0.0)
+        throwSingular();
+
+    Matrix inv;
+
+    for (size_t i = 0; i < 9; ++i)
+        inv.data[i] = adj.data[i] / det;
+
+    return inv;
+}
+
+
+template <typename E>
+constexpr Matrix MatrixExpr<E>::eval() const
+{
+    return Matrix(*this);
+}
+
+#endif // MATRIX_H
@@ -3,8 +3,13 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstdint>
 #include "Vector.h"
 #include "DateTime.h"
+#include "MappedFile.h"
+#include "BinarySeries.h"
+#include "SampleSeries.h"
 
 using std::vector;
 using std::string;
@@ -12,104 +17,138 @@ using std::string;
 
 /* ================= SampleData1D ================= */
 
-struct SamplePoint1D
-{
-    DateTime t;
-    double y;
-
-    SamplePoint1D(const DateTime& time,
-                  double val);
+// Scalar series (see SampleSeries.h, which also holds UniformGrid and
+// SampleCursor)
+using SampleData1D = SampleSeries<double>;
 
-    bool operator<(const SamplePoint1D& other) const;
-};
 
+/* ================= FieldStorage ================= */
 
-class SampleData1D
+// Storage policy of the field series (see SampleSeries.h). Besides owned
+// samples it can read a mapped binary series file in place or stream a
+// CSV through a window, keep a prebuilt interpolant, and scale lazily:
+// operator* shares the samples and multiplies values as they are read.
+class FieldStorage
 {
-private:
-    vector<SamplePoint1D> data;
-    mutable size_t position;
-    bool sorted_;
-
-    void requireSorted() const;
-    size_t findColumn(const vector<string>& header,
-                      const string& name) const;
-    void setPosition(const DateTime t) const;            // changes position
-
 public:
-    SampleData1D();
-
-    SampleData1D(const string& filename,
-                 const string& timeColumn,
-                 const string& valueColumn);
+    static constexpr size_t components = 3;
+
+    FieldStorage();
+
+    // Maps a binary series file written by writeBinary()/csv_to_bin
+    static FieldStorage mapBinary(const string& filename);
+
+    // Opens a field file for a run over [start, stop] without loading
+    // it. Binary series files are mapped. CSV exports are streamed: only
+    // rows in the range (plus a few either side) are parsed, into a
+    // window of about blockRows samples that slides forward as queries
+    // advance, with the next block parsed ahead on a background thread.
+    // Memory stays bounded whatever the file length. Queries must move
+    // forward through time (as simulate() does). size(), timeAt() and
+    // valueAt() refer to the current window; a windowed series cannot
+    // be appended to or written out, and sort() leaves it alone. Its
+    // copies share the one window, so it has a single consumer and
+    // must not be queried from several threads.
+    static FieldStorage openWindow(const string& filename,
+                                   const string& timeColumn,
+                                   const vector<string>& valueColumns,
+                                   const DateTime& start,
+                                   const DateTime& stop,
+                                   size_t blockRows);
+
+    // Written with the scale applied
+    void writeBinary(const string& filename, bool sorted) const;
+
+    // Precomputes the 4-point Lagrange cubic of every interval so that
+    // lagrangeInterpolate() becomes a lookup plus a Horner evaluation.
+    // Agrees with the direct evaluation to within 1e-12 relative (about
+    // 1e-15 in bench_interpolant). Costs 104 bytes per sample. Kept up
+    // to date by sort(), dropped by addSample().
+    void buildInterpolant();
+
+    SeriesView<3> view() const;
+
+    // Owned samples for modification, with the scale applied. Throws
+    // for a mapped or windowed series
+    SeriesSamples<3>& own();
 
-    void addSample(const DateTime& t,
-                   double y);
-
-    void sort();
-    bool checkSort() const;
     bool isSorted() const;
+    bool isMapped() const;
+    bool isWindowed() const;
 
-    double linearInterpolate(const DateTime& t) const;
-    double lagrangeInterpolate(const DateTime& t) const;
-
-    size_t size() const;
+    void advance(int64_t time, SampleCursor& at) const;
+    void invalidate();
+    void rebuild();
+    void scale(double factor);
 
-    // Operators
-    SampleData1D operator*(double scalar) const;
+private:
+    // Owned samples and their prebuilt interpolant, if any. A mapped
+    // series keeps only the grid and interpolant here.
+    struct Owned
+    {
+        SeriesSamples<3> samples;
+        vector<double> interpolant;
+        vector<double> invSpan;
+    };
+    shared_ptr<Owned> owned;
+
+    double factor = 1.0;
+
+    // Zero-copy mode: samples are read in place from a mapped binary
+    // series file (see BinarySeries.h)
+    shared_ptr<const MappedFile> mapped;
+    BinarySeriesView binary;
+
+    // Streaming mode: a sliding window of samples refilled from a
+    // CsvStream
+    struct Window;
+    shared_ptr<Window> window;
+
+    SeriesView<3> windowView() const;
+    void slide(int64_t time, SampleCursor& at) const;
 };
 
+// On every lookup, so kept inline
 
-/* ================= SampleDataVector ================= */
-
-struct SamplePointVector
+inline SeriesView<3> FieldStorage::view() const
 {
-    DateTime t;
-    Vector y;
-
-    SamplePointVector(const DateTime& time,
-                      const Vector& val);
-
-    // Operators
-    bool operator<(const SamplePointVector& other) const;
-};
-
-
-class SampleDataVector
+    if (window)
+        return windowView();
+
+    const Owned& o = *owned;
+    SeriesView<3> v;
+    if (mapped){
+        v.count = binary.count;
+        v.t = binary.ticks;
+        v.columns = {binary.x, binary.y, binary.z};
+    }
+    else {
+        v.count = o.samples.ticks.size();
+        v.t = o.samples.ticks.data();
+        for (size_t d = 0; d < 3; ++d)
+            v.columns[d] = o.samples.columns[d].data();
+    }
+    v.grid = o.samples.grid;
+    v.scale = factor;
+    if (!o.interpolant.empty()){
+        v.coeff = o.interpolant.data();
+        v.invSpan = o.invSpan.data();
+    }
+    return v;
+}
+
+inline void FieldStorage::advance(int64_t time, SampleCursor& at) const
 {
-private:
-    vector<SamplePointVector> data;
-    mutable size_t position = 0;
-    bool sorted_ = false;
-
-    void requireSorted() const;
-    size_t findColumn(const vector<string>& header,
-                      const string& name) const;
-    void setPosition(const DateTime t) const;            // changes position
-
-public:
-    SampleDataVector();
+    if (window)
+        slide(time, at);
+}
 
-    SampleDataVector(const string& filename,
-                     const string& timeColumn,
-                     const string& colX,
-                     const string& colY,
-                     const string& colZ);
 
-    void addSample(const DateTime& t,
-                   const Vector& y);
-
-    void sort();
-    bool checkSort() const;
-    bool isSorted() const;
-
-    Vector linearInterpolate(const DateTime& t) const;
-    Vector lagrangeInterpolate(const DateTime& t) const;
-
-    size_t size() const;
+/* ================= SampleDataVector ================= */
 
-    // Operators
-    SampleDataVector operator*(double scalar) const;
-};
+// The field series: a Vector SampleSeries with the cubic of the
+// simulation and FieldStorage, so it shares every kernel of the other
+// series and adds the mapped, windowed and prebuilt-interpolant modes.
+using SampleDataVector = SampleSeries<Vector, Lagrange<4>, FieldStorage>;
 
 #endif /* NUMERICS_H */
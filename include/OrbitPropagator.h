@@ -0,0 +1,102 @@
+#ifndef ORBIT_PROPAGATOR_H
+#define ORBIT_PROPAGATOR_H
+
+#include "Vector.h"
+#include "DateTime.h"
+#include "SampleSeries.h"
+
+
+/* ================= OrbitElements ================= */
+
+// Classical elements at an epoch, in km and radians. Mean elements when
+// propagated with J2 (see OrbitPropagator::fromState).
+struct OrbitElements
+{
+    double semiMajorAxis = 0;
+    double eccentricity = 0;
+    double inclination = 0;
+    double raan = 0;             // right ascension of the ascending node
+    double argPerigee = 0;
+    double meanAnomaly = 0;
+    DateTime epoch;
+};
+
+
+/* ================= OrbitPropagator ================= */
+
+// Analytic ECI position for any time, in place of a position export.
+// Kepler propagates the two-body ellipse; J2 adds the secular drift of
+// the node, perigee and mean anomaly due to the Earth's oblateness
+// (first order), which is what moves a LEO orbit over days. Short
+// periodic J2 terms (about 10 km in LEO) and drag are not modelled, so a
+// run sees the mean orbit; for the field that is a few tenths of a
+// percent.
+//
+// Answers interpolate(t[, at]) like a position SampleSeries, so it can
+// stand wherever one is used (OrbitField takes either). Every query is
+// independent: the cursor is accepted and ignored, and a const
+// propagator can be shared across threads.
+//
+//     OrbitPropagator orbit = OrbitPropagator::circular(
+//         500.0, 97.4 * M_PI / 180.0, DateTime("01 Oct 2025 00:00:00.000"));
+class OrbitPropagator
+{
+public:
+    enum class Model
+    {
+        Kepler,
+        J2
+    };
+
+    static constexpr double mu = 398600.4418;           // km^3/s^2
+    static constexpr double earthRadius = 6378.137;     // km
+    static constexpr double j2 = 1.08262668e-3;
+
+    explicit OrbitPropagator(const OrbitElements& elements,
+                             Model model = Model::J2);
+
+    // Circular orbit at an altitude above the equatorial radius (km);
+    // argLatitude places the satellite along it at the epoch
+    static OrbitPropagator circular(double altitude, double inclination,
+                                    const DateTime& epoch,
+                                    double raan = 0.0,
+                                    double argLatitude = 0.0,
+                                    Model model = Model::J2);
+
+    // From an ECI state (km, km/s), such as the first rows of an export.
+    // With J2 the semi-major axis is first cleared of its short periodic
+    // part, or the mean motion, and with it the along-track position,
+    // would drift by several km per orbit.
+    static OrbitPropagator fromState(const Vector& position,
+                                     const Vector& velocity,
+                                     const DateTime& epoch,
+                                     Model model = Model::J2);
+
+    // ECI position (km) and velocity (km/s)
+    Vector position(const DateTime& t) const;
+    Vector velocity(const DateTime& t) const;
+    void state(const DateTime& t, Vector& position, Vector& velocity) const;
+
+    // Position source interface of SampleSeries<Vector>
+    Vector interpolate(const DateTime& t) const;
+    Vector interpolate(const DateTime& t, SampleCursor& at) const;
+
+    const OrbitElements& elements() const;
+    Model model() const;
+    double period() const;       // anomalistic, s
+
+    // Secular rates (rad/s)
+    double raanRate() const;
+    double argPerigeeRate() const;
+    double meanAnomalyRate() const;
+
+private:
+    OrbitElements elements_;
+    Model model_;
+
+    double raanDot = 0;
+    double argPerigeeDot = 0;
+    double meanAnomalyDot = 0;
+};
+
+#endif /* ORBIT_PROPAGATOR_H */
@@ -0,0 +1,179 @@
+// Quaternion.h
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include <array>
+#include <cmath>
+#include <string>
+#include "Vector.h"
+#include "Matrix.h"
+using namespace std;
+
+// Unit quaternion q = w + xi + yj + zk describing the rotation from the
+// body frame to the inertial frame. Four doubles replace the three axis
+// vectors (nine doubles) and stay orthonormal by construction; only the
+// norm has to be maintained, which is one rescale per step.
+class Quaternion
+{
+public:
+    double w = 1.0;
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+
+    // Constructors
+    constexpr Quaternion() = default;
+    constexpr Quaternion(double w, double x, double y, double z)
+        : w(w), x(x), y(y), z(z) {}
+
+    // Closed form exponential map: rotation of |v| radians about v
+    static Quaternion fromRotationVector(const Vector& v);
+
+    // Rotation whose matrix has the body axes X, Y, Z as its columns
+    static Quaternion fromAxes(const Vector& X,
+                               const Vector& Y,
+                               const Vector& Z);
+
+    // Operators
+    constexpr Quaternion operator*(const Quaternion& q) const;   // Hamilton
+    constexpr Quaternion conjugate() const;
+
+    // Functions to get characteristic values of a quaternion
+    constexpr double normSquared() const;
+    Quaternion normalized() const;
+
+    // Rotates a vector from the body frame to the inertial frame
+    constexpr Vector rotate(const Vector& v) const;
+
+    // Body axes expressed in the inertial frame (columns of toMatrix())
+    constexpr array<Vector, 3> toAxes() const;
+    constexpr Matrix toMatrix() const;
+
+    string display() const;
+};
+
+
+inline Quaternion Quaternion::fromRotationVector(const Vector& v)
+{
+    double angle2 = v * v;
+    double angle = sqrt(angle2);
+
+    // sin(a/2)/a, with its Taylor series near zero so a vanishing
+    // rotation needs no special casing
+    double c, s;
+    if (angle < 1e-4){
+        c = 1.0 - angle2 / 8.0;
+        s = 0.5 - angle2 / 48.0;
+    } else {
+        c = cos(0.5 * angle);
+        s = sin(0.5 * angle) / angle;
+    }
+
+    return Quaternion(c, s * v[0], s * v[1], s * v[2]);
+}
+
+
+inline Quaternion Quaternion::fromAxes(const Vector& X,
+                                       const Vector& Y,
+                                       const Vector& Z)
+{
+    // Shepperd's method on R = [X Y Z], choosing the largest pivot
+    double m00 = X[0], m01 = Y[0], m02 = Z[0];
+    double m10 = X[1], m11 = Y[1], m12 = Z[1];
+    double m20 = X[2], m21 = Y[2], m22 = Z[2];
+    double trace = m00 + m11 + m22;
+
+    Quaternion q;
+    if (trace > 0.0){
+        double s = 2.0 * sqrt(1.0 + trace);
+        q = Quaternion(0.25 * s,
+                       (m21 - m12) / s,
+                       (m02 - m20) / s,
+                       (m10 - m01) / s);
+    } else if (m00 > m11 && m00 > m22){
+        double s = 2.0 * sqrt(1.0 + m00 - m11 - m22);
+        q = Quaternion((m21 - m12) / s,
+                       0.25 * s,
+                       (m01 + m10) / s,
+                       (m02 + m20) / s);
+    } else if (m11 > m22){
+        double s = 2.0 * sqrt(1.0 + m11 - m00 - m22);
+        q = Quaternion((m02 - m20) / s,
+                       (m01 + m10) / s,
+                       0.25 * s,
+                       (m12 + m21) / s);
+    } else {
+        double s = 2.0 * sqrt(1.0 + m22 - m00 - m11);
+        q = Quaternion((m10 - m01) / s,
+                       (m02 + m20) / s,
+                       (m12 + m21) / s,
+                       0.25 * s);
+    }
+    return q.normalized();
+}
+
+
+constexpr Quaternion Quaternion::operator*(const Quaternion& q) const
+{
+    return Quaternion(
+        w * q.w - x * q.x - y * q.y - z * q.z,
+        w * q.x + x * q.w + y * q.z - z * q.y,
+        w * q.y - x * q.z + y * q.w + z * q.x,
+        w * q.z + x * q.y - y * q.x + z * q.w
+    );
+}
+
+
+constexpr Quaternion Quaternion::conjugate() const
+{
+    return Quaternion(w, -x, -y, -z);
+}
+
+
+constexpr double Quaternion::normSquared() const
+{
+    return w * w + x * x + y * y + z * z;
+}
+
+
+inline Quaternion Quaternion::normalized() const
+{
+    double inv = 1.0 / sqrt(normSquared());
+    return Quaternion(w * inv, x * inv, y * inv, z * inv);
+}
+
+
+constexpr Vector Quaternion::rotate(const Vector& v) const
+{
+    // v' = v + 2w(u x v) + 2u x (u x v), u = (x, y, z)
+    Vector u = {x, y, z};
+    Vector t = (u ^ v) * 2.0;
+    return v + t * w + (u ^ t);
+}
+
+
+constexpr Matrix Quaternion::toMatrix() const
+{
+    double xx = x * x, yy = y * y, zz = z * z;
+    double xy = x * y, xz = x * z, yz = y * z;
+    double wx = w * x, wy = w * y, wz = w * z;
+
+    return Matrix{
+        1 - 2 * (yy + zz),  2 * (xy - wz),      2 * (xz + wy),
+        2 * (xy + wz),      1 - 2 * (xx + zz),  2 * (yz - wx),
+        2 * (xz - wy),      2 * (yz + wx),      1 - 2 * (xx + yy)
+    };
+}
+
+
+constexpr array<Vector, 3> Quaternion::toAxes() const
+{
+    Matrix R = toMatrix();
+    return {
+        Vector{R(0, 0), R(1, 0), R(2, 0)},
+        Vector{R(0, 1), R(1, 1), R(2, 1)},
+        Vector{R(0, 2), R(1, 2), R(2, 2)}
+    };
+}
+
+#endif // QUATERNION_H
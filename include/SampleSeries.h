@@ -0,0 +1,471 @@
+#ifndef SAMPLE_SERIES_H
+#define SAMPLE_SERIES_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include "CsvReader.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "DateTime.h"
+
+using std::vector;
+using std::string;
+
+
+/* ================= UniformGrid ================= */
+
+// Regular sampling detected at load and sort(): t[i] == start + i * step
+// exactly (in ticks), so the interval of a time is one division away.
+// step == 0 means the spacing is irregular and lookups binary search.
+struct UniformGrid
+{
+    int64_t start = 0;
+    int64_t step = 0;
+
+    bool valid() const { return step > 0; }
+};
+
+
+/* ================= SampleCursor ================= */
+
+// Where the previous lookup landed in a series, so that the next
+// sequential query starts there. It is only a hint (any cursor gives the
+// same results), and it lives outside the series, so one series can be
+// shared read-only by many threads, each querying through its own.
+struct SampleCursor
+{
+    size_t position = 0;
+};
+
+
+/* ================= Interpolation schemes ================= */
+
+// Compile-time parameters of SampleSeries. A scheme has a stencil of
+// `points` samples, placed around the interval holding the query time
+// by first(), and the weights of those samples at the query time. The
+// weight loops run over a constant count and are unrolled.
+
+// Straight line through the two samples around t
+struct Linear
+{
+    static constexpr size_t points = 2;
+
+    static size_t first(size_t interval, size_t n);
+    static void weights(const int64_t* t, int64_t time, double* w);
+};
+
+// Polynomial through the Points samples nearest t, Points / 2 on each
+// side of the interval where the data allows. Differences are taken in
+// integer ticks first, so no precision is lost to the size of the epoch
+// offset. Lagrange<4> is the cubic the simulation uses.
+template <size_t Points>
+struct Lagrange
+{
+    static_assert(Points >= 2, "Lagrange needs at least two points");
+    static constexpr size_t points = Points;
+
+    static size_t first(size_t interval, size_t n);
+    static void weights(const int64_t* t, int64_t time, double* w);
+};
+
+
+/* ================= SeriesTraits ================= */
+
+// How a value type is stored: as `components` doubles, each in its own
+// column. finish() is applied to every interpolated value.
+template <typename T>
+struct SeriesTraits;
+
+template <>
+struct SeriesTraits<double>
+{
+    static constexpr size_t components = 1;
+    static constexpr bool signSymmetric = false;
+
+    static void split(double v, double* c) { c[0] = v; }
+    static double join(const double* c) { return c[0]; }
+    static double finish(double v) { return v; }
+};
+
+template <>
+struct SeriesTraits<Vector>
+{
+    static constexpr size_t components = 3;
+    static constexpr bool signSymmetric = false;
+
+    static void split(const Vector& v, double* c)
+    {
+        c[0] = v[0]; c[1] = v[1]; c[2] = v[2];
+    }
+    static Vector join(const double* c) { return Vector{c[0], c[1], c[2]}; }
+    static Vector finish(const Vector& v) { return v; }
+};
+
+template <>
+struct SeriesTraits<Matrix>
+{
+    static constexpr size_t components = 9;
+    static constexpr bool signSymmetric = false;
+
+    static void split(const Matrix& m, double* c)
+    {
+        for (size_t i = 0; i < 9; ++i)
+            c[i] = m.coeff(i);
+    }
+    static Matrix join(const double* c)
+    {
+        return Matrix{c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], c[8]};
+    }
+    static Matrix finish(const Matrix& m) { return m; }
+};
+
+// q and -q are the same rotation, so sort() flips samples onto the
+// hemisphere of their predecessor before anything is interpolated, and
+// interpolated values are renormalised
+template <>
+struct SeriesTraits<Quaternion>
+{
+    static constexpr size_t components = 4;
+    static constexpr bool signSymmetric = true;
+
+    static void split(const Quaternion& q, double* c)
+    {
+        c[0] = q.w; c[1] = q.x; c[2] = q.y; c[3] = q.z;
+    }
+    static Quaternion join(const double* c)
+    {
+        return Quaternion(c[0], c[1], c[2], c[3]);
+    }
+    static Quaternion finish(const Quaternion& q) { return q.normalized(); }
+};
+
+
+/* ================= Shared helpers ================= */
+
+// Lookup, sorting and batch kernels of SampleSeries
+namespace series
+{
+    // Index i with t[i] <= time < t[i + 1] (0 before the first sample,
+    // n - 1 from the last one on). The hint (the previous answer) is
+    // tried first. After that, a uniform grid computes the index
+    // directly, and irregular data tries the hint's successor and then
+    // binary searches the side of the hint that holds time. Sequential
+    // queries stay O(1), and a jump anywhere in the series costs
+    // O(log n).
+    inline size_t locate(const int64_t* t, size_t n, const UniformGrid& grid,
+                         size_t hint, int64_t time)
+    {
+        if (hint + 1 < n && !(time < t[hint]) && time < t[hint + 1])
+            return hint;
+
+        if (grid.valid()){
+            if (time < grid.start)
+                return 0;
+            uint64_t i = static_cast<uint64_t>(time - grid.start)
+                       / static_cast<uint64_t>(grid.step);
+            return i < n ? static_cast<size_t>(i) : n - 1;
+        }
+
+        if (hint >= n)
+            hint = n - 1;
+
+        if (!(time < t[hint])){
+            if (hint + 1 >= n || time < t[hint + 1])
+                return hint;
+            if (hint + 2 >= n || time < t[hint + 2])
+                return hint + 1;
+            return std::upper_bound(t + hint + 2, t + n, time) - t - 1;
+        }
+
+        const int64_t* it = std::upper_bound(t, t + hint, time);
+        return it == t ? 0 : static_cast<size_t>(it - t - 1);
+    }
+
+    // Detects exact uniform spacing of sorted ticks
+    inline UniformGrid detectGrid(const int64_t* t, size_t n)
+    {
+        if (n < 2 || t[1] <= t[0])
+            return UniformGrid();
+
+        int64_t step = t[1] - t[0];
+        for (size_t i = 2; i < n; ++i)
+        {
+            if (t[i] - t[i - 1] != step)
+                return UniformGrid();
+        }
+        return UniformGrid{t[0], step};
+    }
+
+    inline bool ticksSorted(const int64_t* t, size_t n)
+    {
+        for (size_t i = 1; i < n; ++i)
+        {
+            if (t[i] < t[i - 1])
+                return false;
+        }
+        return true;
+    }
+
+    // Index order that sorts ticks (stable, so equal stamps keep their
+    // load order)
+    inline vector<size_t> sortOrder(const vector<int64_t>& ticks)
+    {
+        vector<size_t> order(ticks.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(),
+                         [&ticks](size_t a, size_t b){
+                             return ticks[a] < ticks[b];
+                         });
+        return order;
+    }
+
+    template <typename T>
+    void gather(vector<T>& column, const vector<size_t>& order)
+    {
+        vector<T> sorted(column.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            sorted[i] = column[order[i]];
+        column.swap(sorted);
+    }
+
+    // Calls f(integral_constant<size_t, I>) for I = 0 .. N - 1, written
+    // out in full rather than looped
+    template <typename F, size_t... I>
+    inline void unrollImpl(F&& f, std::index_sequence<I...>)
+    {
+        (f(std::integral_constant<size_t, I>()), ...);
+    }
+
+    template <size_t N, typename F>
+    inline void unroll(F&& f)
+    {
+        unrollImpl(f, std::make_index_sequence<N>());
+    }
+
+    // Lagrange basis weights from the offsets d_j = time - t_j to the
+    // four nodes and the node spacings a_ij = t_i - t_j, for the batch
+    // path. Rounds exactly like Lagrange<4>::weights (the single query
+    // path); plain arithmetic, so it vectorises when inlined into a loop.
+    inline void lagrangeWeights(double d0, double d1, double d2, double d3,
+                                double a01, double a02, double a03,
+                                double a12, double a13, double a23,
+                                double& w0, double& w1,
+                                double& w2, double& w3)
+    {
+        w0 = (d1 * d2 * d3) / (a01 * a02 * a03);
+        w1 = (d0 * d2 * d3) / (-a01 * a12 * a13);
+        w2 = (d0 * d1 * d3) / (a02 * a12 * a23);
+        w3 = (d0 * d1 * d2) / -(a03 * a13 * a23);
+    }
+
+    // Queries handled per pass by the batch interpolators (scratch
+    // arrays live on the stack and stay in L1)
+    constexpr size_t batchChunk = 128;
+}
+
+
+/* ================= Storage ================= */
+
+// Samples of a series: the ticks, then one column per component
+template <size_t C>
+struct SeriesSamples
+{
+    vector<int64_t> ticks;
+    std::array<vector<double>, C> columns;
+    UniformGrid grid;
+};
+
+// Raw column pointers of whatever holds the samples, read by the lookup
+// kernels. Values are multiplied by scale as they are read. coeff, when
+// not null, is a prebuilt Lagrange<4> interpolant: per interval the
+// cubic in s = (t - t[i]) / (t[i+1] - t[i]) as 4 monomial coefficients
+// per component, with invSpan[i] = 1 / (t[i+1] - t[i]).
+template <size_t C>
+struct SeriesView
+{
+    size_t count = 0;
+    const int64_t* t = nullptr;
+    std::array<const double*, C> columns{};
+    UniformGrid grid;
+    double scale = 1.0;
+    const double* coeff = nullptr;
+    const double* invSpan = nullptr;
+};
+
+// The storage policy of a SampleSeries: where its samples live. A
+// policy hands out a SeriesView for lookups and its SeriesSamples for
+// modification through own(), which unshares them first (copy on write)
+// and throws if the storage is read-only. advance() is called before
+// each lookup, and invalidate() and rebuild() after an append and a
+// sort, for storage that keeps something derived from the samples.
+//
+// OwnedStorage is the plain in-memory form. FieldStorage (Numerics.h)
+// adds the mapped, windowed and prebuilt-interpolant modes of the field
+// data.
+template <size_t C>
+class OwnedStorage
+{
+public:
+    static constexpr size_t components = C;
+
+    OwnedStorage()
+        : samples(std::make_shared<SeriesSamples<C>>())
+    {
+    }
+
+    SeriesView<C> view() const
+    {
+        SeriesView<C> v;
+        v.count = samples->ticks.size();
+        v.t = samples->ticks.data();
+        for (size_t d = 0; d < C; ++d)
+            v.columns[d] = samples->columns[d].data();
+        v.grid = samples->grid;
+        return v;
+    }
+
+    SeriesSamples<C>& own()
+    {
+        if (samples.use_count() > 1)
+            samples = std::make_shared<SeriesSamples<C>>(*samples);
+        return *samples;
+    }
+
+    bool isSorted() const { return true; }
+    bool isMapped() const { return false; }
+    bool isWindowed() const { return false; }
+
+    void advance(int64_t, SampleCursor&) const {}
+    void invalidate() {}
+    void rebuild() {}
+
+    void scale(double factor)
+    {
+        for (vector<double>& column : own().columns)
+            for (double& v : column)
+                v *= factor;
+    }
+
+private:
+    std::shared_ptr<SeriesSamples<C>> samples;
+};
+
+
+/* ================= SampleSeries ================= */
+
+// Time series of any value type with SeriesTraits, interpolated by the
+// compile-time Scheme and held by the Storage policy. Stored as a
+// structure of arrays (the ticks, then one column per component) in
+// immutable shared storage: copies share the samples and the non-const
+// members copy them first if anyone else still holds them. Queries that
+// take a SampleCursor only read the series, so a const series may be
+// used from any number of threads at once; the overloads without a
+// cursor use one kept inside the series and are for single-threaded
+// use.
+//
+//     SampleSeries<Vector, Lagrange<8>> sunVector(file, time, {x, y, z});
+//     SampleSeries<Quaternion> attitude;   // Lagrange<4>
+//     SampleDataVector field;              // FieldStorage, see Numerics.h
+template <typename T, typename Scheme = Lagrange<4>,
+          typename Storage = OwnedStorage<SeriesTraits<T>::components>>
+class SampleSeries
+{
+public:
+    using Traits = SeriesTraits<T>;
+    static constexpr size_t components = Traits::components;
+
+    static_assert(Storage::components == components,
+                  "Storage must hold one column per component");
+
+    SampleSeries();
+
+    // One value column per component, in SeriesTraits order
+    SampleSeries(const string& filename,
+                 const string& timeColumn,
+                 const vector<string>& valueColumns);
+
+    // Modes of FieldStorage (see Numerics.h)
+    static SampleSeries mapBinary(const string& filename);
+    static SampleSeries openWindow(const string& filename,
+                                   const string& timeColumn,
+                                   const vector<string>& valueColumns,
+                                   const DateTime& start,
+                                   const DateTime& stop,
+                                   size_t blockRows = 1 << 16);
+    void writeBinary(const string& filename) const;
+    void buildInterpolant();
+
+    bool isMapped() const;
+    bool isWindowed() const;
+    bool hasInterpolant() const;
+
+    void addSample(const DateTime& t, const T& value);
+
+    void sort();
+    bool checkSort() const;
+    bool isSorted() const;
+    bool isUniform() const;
+
+    // Value at t by Scheme, or by another scheme given explicitly
+    // (interpolate<Linear>(t)). Outside the samples the first or last
+    // stencil is extrapolated.
+    template <typename S = Scheme>
+    T interpolate(const DateTime& t) const;
+    template <typename S = Scheme>
+    T interpolate(const DateTime& t, SampleCursor& at) const;
+
+    // The two schemes the simulation uses
+    T linearInterpolate(const DateTime& t) const;
+    T lagrangeInterpolate(const DateTime& t) const;
+    T linearInterpolate(const DateTime& t, SampleCursor& at) const;
+    T lagrangeInterpolate(const DateTime& t, SampleCursor& at) const;
+
+    // Batch forms for Vector series: count query times (non-decreasing
+    // for speed, though any order gives the same results) written to
+    // x[k], y[k], z[k]. Queries are located in one pass and evaluated in
+    // a second, branch free pass over contiguous scratch arrays that the
+    // compiler turns into SIMD. Results match the single-query calls
+    // exactly.
+    void linearInterpolate(const DateTime* times, size_t count,
+                           double* x, double* y, double* z) const;
+    void lagrangeInterpolate(const DateTime* times, size_t count,
+                             double* x, double* y, double* z) const;
+    void linearInterpolate(const DateTime* times, size_t count,
+                           double* x, double* y, double* z,
+                           SampleCursor& at) const;
+    void lagrangeInterpolate(const DateTime* times, size_t count,
+                             double* x, double* y, double* z,
+                             SampleCursor& at) const;
+
+    size_t size() const;
+
+    // Accessors for the i-th sample
+    DateTime timeAt(size_t i) const;
+    T valueAt(size_t i) const;
+
+    // Operators
+    SampleSeries operator*(double scalar) const;
+
+private:
+    Storage storage;
+
+    mutable SampleCursor cursor;
+    bool sorted_ = true;
+
+    explicit SampleSeries(Storage loaded);
+
+    void requireSorted() const;
+};
+
+#include "SampleSeries.tpp"
+
+#endif /* SAMPLE_SERIES_H */
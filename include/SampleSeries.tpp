@@ -0,0 +1,574 @@
+// SampleSeries.tpp -- included by SampleSeries.h
+
+/* ================= Interpolation schemes ================= */
+
+inline size_t Linear::first(size_t interval, size_t n)
+{
+    // Extrapolating from the last interval past the end
+    return std::min(interval, n - 2);
+}
+
+inline void Linear::weights(const int64_t* t, int64_t time, double* w)
+{
+    double f = static_cast<double>(time - t[0])
+             / static_cast<double>(t[1] - t[0]);
+    w[0] = 1.0 - f;
+    w[1] = f;
+}
+
+template <size_t Points>
+inline size_t Lagrange<Points>::first(size_t interval, size_t n)
+{
+    constexpr size_t before = (Points - 1) / 2;
+
+    size_t start = interval > before ? interval - before : 0;
+    return std::min(start, n - Points);
+}
+
+// w_k = prod_{j != k} (time - t_j) / (t_k - t_j), both products taken in
+// node order. For four points this rounds exactly like
+// series::lagrangeWeights (the batch path).
+template <size_t Points>
+inline void Lagrange<Points>::weights(const int64_t* t, int64_t time,
+                                      double* w)
+{
+    double d[Points];
+    series::unroll<Points>([&](auto j){
+        d[j] = static_cast<double>(time - t[j]);
+    });
+
+    series::unroll<Points>([&](auto k){
+        constexpr size_t K = decltype(k)::value;
+        double num = 1.0, den = 1.0;
+        series::unroll<Points>([&](auto j){
+            constexpr size_t J = decltype(j)::value;
+            if constexpr (J != K){
+                num *= d[J];
+                den *= static_cast<double>(t[K] - t[J]);
+            }
+        });
+        w[K] = num / den;
+    });
+}
+
+
+/* ================= SampleSeries ================= */
+
+template <typename T, typename Scheme, typename Storage>
+SampleSeries<T, Scheme, Storage>::SampleSeries()
+{
+}
+
+template <typename T, typename Scheme, typename Storage>
+SampleSeries<T, Scheme, Storage>::SampleSeries(Storage loaded)
+    : storage(std::move(loaded)), sorted_(storage.isSorted())
+{
+}
+
+template <typename T, typename Scheme, typename Storage>
+SampleSeries<T, Scheme, Storage>::SampleSeries(
+    const string& filename,
+    const string& timeColumn,
+    const vector<string>& valueColumns)
+{
+    if (valueColumns.size() != components)
+        throw std::invalid_argument(
+            "SampleSeries needs one value column per component"
+        );
+
+    CsvSeries csv = readCsvSeries(filename, timeColumn, valueColumns);
+
+    SeriesSamples<components>& s = storage.own();
+    size_t n = csv.rows();
+    s.ticks = std::move(csv.ticks);
+    for (size_t d = 0; d < components; ++d)
+    {
+        s.columns[d].resize(n);
+        for (size_t i = 0; i < n; ++i)
+            s.columns[d][i] = csv.values[components * i + d];
+    }
+
+    sorted_ = checkSort();
+    if (sorted_)
+        sort();
+}
+
+template <typename T, typename Scheme, typename Storage>
+SampleSeries<T, Scheme, Storage>
+SampleSeries<T, Scheme, Storage>::mapBinary(const string& filename)
+{
+    return SampleSeries(Storage::mapBinary(filename));
+}
+
+template <typename T, typename Scheme, typename Storage>
+SampleSeries<T, Scheme, Storage>
+SampleSeries<T, Scheme, Storage>::openWindow(
+    const string& filename,
+    const string& timeColumn,
+    const vector<string>& valueColumns,
+    const DateTime& start,
+    const DateTime& stop,
+    size_t blockRows)
+{
+    if (valueColumns.size() != components)
+        throw std::invalid_argument(
+            "SampleSeries needs one value column per component"
+        );
+    return SampleSeries(Storage::openWindow(filename, timeColumn,
+                                            valueColumns, start, stop,
+                                            blockRows));
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::writeBinary(
+    const string& filename) const
+{
+    storage.writeBinary(filename, sorted_);
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::buildInterpolant()
+{
+    requireSorted();
+    storage.buildInterpolant();
+}
+
+template <typename T, typename Scheme, typename Storage>
+bool SampleSeries<T, Scheme, Storage>::isMapped() const
+{
+    return storage.isMapped();
+}
+
+template <typename T, typename Scheme, typename Storage>
+bool SampleSeries<T, Scheme, Storage>::isWindowed() const
+{
+    return storage.isWindowed();
+}
+
+template <typename T, typename Scheme, typename Storage>
+bool SampleSeries<T, Scheme, Storage>::hasInterpolant() const
+{
+    return storage.view().coeff != nullptr;
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::addSample(const DateTime& t,
+                                                 const T& value)
+{
+    SeriesSamples<components>& s = storage.own();
+    storage.invalidate();
+
+    double c[components];
+    Traits::split(value, c);
+
+    s.ticks.push_back(t.ticks());
+    for (size_t d = 0; d < components; ++d)
+        s.columns[d].push_back(c[d]);
+    sorted_ = false;
+    s.grid = UniformGrid();
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::sort()
+{
+    // A window is checked block by block as it slides
+    if (storage.isWindowed())
+        return;
+
+    if (storage.isMapped()){
+        if (!checkSort())
+            throw std::runtime_error(
+                "Mapped SampleSeries is read-only and not sorted"
+            );
+        sorted_ = true;
+        cursor = SampleCursor();
+        return;
+    }
+
+    SeriesSamples<components>& s = storage.own();
+    if (!checkSort()){
+        vector<size_t> order = series::sortOrder(s.ticks);
+        series::gather(s.ticks, order);
+        for (vector<double>& column : s.columns)
+            series::gather(column, order);
+    }
+
+    if constexpr (Traits::signSymmetric){
+        for (size_t i = 1; i < s.ticks.size(); ++i)
+        {
+            double dot = 0.0;
+            for (const vector<double>& column : s.columns)
+                dot += column[i] * column[i - 1];
+            if (dot < 0.0)
+                for (vector<double>& column : s.columns)
+                    column[i] = -column[i];
+        }
+    }
+
+    sorted_ = true;
+    s.grid = series::detectGrid(s.ticks.data(), s.ticks.size());
+    cursor = SampleCursor();
+    storage.rebuild();
+}
+
+template <typename T, typename Scheme, typename Storage>
+bool SampleSeries<T, Scheme, Storage>::checkSort() const
+{
+    SeriesView<components> v = storage.view();
+    return series::ticksSorted(v.t, v.count);
+}
+
+template <typename T, typename Scheme, typename Storage>
+bool SampleSeries<T, Scheme, Storage>::isSorted() const
+{
+    return sorted_;
+}
+
+template <typename T, typename Scheme, typename Storage>
+bool SampleSeries<T, Scheme, Storage>::isUniform() const
+{
+    return storage.view().grid.valid();
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::requireSorted() const
+{
+    if (!sorted_)
+        throw std::runtime_error("SampleSeries not sorted");
+}
+
+template <typename T, typename Scheme, typename Storage>
+template <typename S>
+T SampleSeries<T, Scheme, Storage>::interpolate(const DateTime& t) const
+{
+    return interpolate<S>(t, cursor);
+}
+
+template <typename T, typename Scheme, typename Storage>
+template <typename S>
+T SampleSeries<T, Scheme, Storage>::interpolate(const DateTime& t,
+                                                SampleCursor& at) const
+{
+    requireSorted();
+
+    int64_t time = t.ticks();
+    storage.advance(time, at);
+
+    SeriesView<components> v = storage.view();
+    size_t n = v.count;
+    if (n < S::points)
+        throw std::runtime_error(
+            "SampleSeries has fewer samples than the interpolation stencil"
+        );
+
+    at.position = series::locate(v.t, n, v.grid, at.position, time);
+
+    double c[components];
+
+    // A prebuilt cubic: a Horner evaluation in the interval, the last
+    // one extrapolated past the final sample
+    if constexpr (std::is_same<S, Lagrange<4>>::value){
+        if (v.coeff){
+            size_t i = std::min(at.position, n - 2);
+            double u = static_cast<double>(time - v.t[i]) * v.invSpan[i];
+            const double* k = v.coeff + 4 * components * i;
+
+            series::unroll<components>([&](auto d){
+                const double* q = k + 4 * d;
+                c[d] = (((q[3] * u + q[2]) * u + q[1]) * u + q[0])
+                     * v.scale;
+            });
+            return Traits::finish(Traits::join(c));
+        }
+    }
+
+    size_t i0 = S::first(at.position, n);
+
+    double w[S::points];
+    S::weights(v.t + i0, time, w);
+
+    series::unroll<components>([&](auto d){
+        const double* y = v.columns[d] + i0;
+        double sum = 0.0;
+        series::unroll<S::points>([&](auto k){
+            sum += y[k] * w[k];
+        });
+        c[d] = sum * v.scale;
+    });
+
+    return Traits::finish(Traits::join(c));
+}
+
+template <typename T, typename Scheme, typename Storage>
+T SampleSeries<T, Scheme, Storage>::linearInterpolate(const DateTime& t) const
+{
+    return interpolate<Linear>(t, cursor);
+}
+
+template <typename T, typename Scheme, typename Storage>
+T SampleSeries<T, Scheme, Storage>::lagrangeInterpolate(
+    const DateTime& t) const
+{
+    return interpolate<Lagrange<4>>(t, cursor);
+}
+
+template <typename T, typename Scheme, typename Storage>
+T SampleSeries<T, Scheme, Storage>::linearInterpolate(
+    const DateTime& t, SampleCursor& at) const
+{
+    return interpolate<Linear>(t, at);
+}
+
+template <typename T, typename Scheme, typename Storage>
+T SampleSeries<T, Scheme, Storage>::lagrangeInterpolate(
+    const DateTime& t, SampleCursor& at) const
+{
+    return interpolate<Lagrange<4>>(t, at);
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::linearInterpolate(
+    const DateTime* times, size_t count,
+    double* x, double* y, double* z) const
+{
+    linearInterpolate(times, count, x, y, z, cursor);
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::lagrangeInterpolate(
+    const DateTime* times, size_t count,
+    double* x, double* y, double* z) const
+{
+    lagrangeInterpolate(times, count, x, y, z, cursor);
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::linearInterpolate(
+    const DateTime* times, size_t count,
+    double* x, double* y, double* z,
+    SampleCursor& at) const
+{
+    static_assert(components == 3, "Batch interpolation is for Vector series");
+    using series::batchChunk;
+
+    requireSorted();
+
+    // The window may slide mid-batch; one query at a time
+    if (storage.isWindowed()){
+        for (size_t k = 0; k < count; ++k){
+            T v = interpolate<Linear>(times[k], at);
+            x[k] = v[0];
+            y[k] = v[1];
+            z[k] = v[2];
+        }
+        return;
+    }
+
+    SeriesView<components> v = storage.view();
+    size_t n = v.count;
+    if (n < Linear::points)
+        throw std::runtime_error(
+            "SampleSeries has fewer samples than the interpolation stencil"
+        );
+
+    double num[batchChunk], den[batchChunk];
+    double x0[batchChunk], x1[batchChunk];
+    double y0[batchChunk], y1[batchChunk];
+    double z0[batchChunk], z1[batchChunk];
+
+    for (size_t base = 0; base < count; base += batchChunk)
+    {
+        size_t m = std::min(batchChunk, count - base);
+
+        /* Pass 1: locate and gather (sequential, follows the cursor) */
+        for (size_t k = 0; k < m; ++k)
+        {
+            int64_t time = times[base + k].ticks();
+            at.position = series::locate(v.t, n, v.grid, at.position, time);
+
+            size_t i = Linear::first(at.position, n);
+            num[k] = static_cast<double>(time - v.t[i]);
+            den[k] = static_cast<double>(v.t[i + 1] - v.t[i]);
+            x0[k] = v.columns[0][i];  x1[k] = v.columns[0][i + 1];
+            y0[k] = v.columns[1][i];  y1[k] = v.columns[1][i + 1];
+            z0[k] = v.columns[2][i];  z1[k] = v.columns[2][i + 1];
+        }
+
+        /* Pass 2: evaluate (independent per query, vectorised), with
+           the weights and sums of Linear in the single query path */
+        double* xo = x + base;
+        double* yo = y + base;
+        double* zo = z + base;
+        for (size_t k = 0; k < m; ++k)
+        {
+            double f = num[k] / den[k];
+            double w0 = 1.0 - f;
+
+            double sx = 0.0, sy = 0.0, sz = 0.0;
+            sx += x0[k] * w0;  sy += y0[k] * w0;  sz += z0[k] * w0;
+            sx += x1[k] * f;   sy += y1[k] * f;   sz += z1[k] * f;
+
+            xo[k] = sx * v.scale;
+            yo[k] = sy * v.scale;
+            zo[k] = sz * v.scale;
+        }
+    }
+}
+
+template <typename T, typename Scheme, typename Storage>
+void SampleSeries<T, Scheme, Storage>::lagrangeInterpolate(
+    const DateTime* times, size_t count,
+    double* x, double* y, double* z,
+    SampleCursor& at) const
+{
+    static_assert(components == 3, "Batch interpolation is for Vector series");
+    using series::batchChunk;
+
+    requireSorted();
+
+    // The window may slide mid-batch; one query at a time
+    if (storage.isWindowed()){
+        for (size_t k = 0; k < count; ++k){
+            T v = interpolate<Lagrange<4>>(times[k], at);
+            x[k] = v[0];
+            y[k] = v[1];
+            z[k] = v[2];
+        }
+        return;
+    }
+
+    SeriesView<components> v = storage.view();
+    size_t n = v.count;
+    if (n < Lagrange<4>::points)
+        throw std::runtime_error(
+            "SampleSeries has fewer samples than the interpolation stencil"
+        );
+
+    if (v.coeff){
+        size_t idx[batchChunk];
+        double u[batchChunk];
+
+        for (size_t base = 0; base < count; base += batchChunk)
+        {
+            size_t m = std::min(batchChunk, count - base);
+
+            for (size_t k = 0; k < m; ++k)
+            {
+                int64_t time = times[base + k].ticks();
+                at.position = series::locate(v.t, n, v.grid, at.position,
+                                             time);
+
+                size_t i = std::min(at.position, n - 2);
+                idx[k] = 4 * components * i;
+                u[k] = static_cast<double>(time - v.t[i]) * v.invSpan[i];
+            }
+
+            const double* coeff = v.coeff;
+            double* xo = x + base;
+            double* yo = y + base;
+            double* zo = z + base;
+            for (size_t k = 0; k < m; ++k)
+            {
+                const double* q = coeff + idx[k];
+                double s = u[k];
+                xo[k] = (((q[3]  * s + q[2])  * s + q[1]) * s + q[0])
+                      * v.scale;
+                yo[k] = (((q[7]  * s + q[6])  * s + q[5]) * s + q[4])
+                      * v.scale;
+                zo[k] = (((q[11] * s + q[10]) * s + q[9]) * s + q[8])
+                      * v.scale;
+            }
+        }
+        return;
+    }
+
+    // Direct path: pass 1 gathers each query's stencil (time offsets,
+    // node spacings and values) into scratch columns; pass 2 forms the
+    // weights with lagrangeWeights(), which rounds like the single query
+    double d[4][batchChunk];
+    double a01[batchChunk], a02[batchChunk], a03[batchChunk];
+    double a12[batchChunk], a13[batchChunk], a23[batchChunk];
+    double vx[4][batchChunk], vy[4][batchChunk], vz[4][batchChunk];
+
+    for (size_t base = 0; base < count; base += batchChunk)
+    {
+        size_t m = std::min(batchChunk, count - base);
+
+        /* Pass 1: locate and gather (sequential, follows the cursor) */
+        for (size_t k = 0; k < m; ++k)
+        {
+            int64_t time = times[base + k].ticks();
+            at.position = series::locate(v.t, n, v.grid, at.position, time);
+
+            size_t i0 = Lagrange<4>::first(at.position, n);
+            const int64_t* pt = v.t + i0;
+            for (int j = 0; j < 4; ++j){
+                d[j][k]  = static_cast<double>(time - pt[j]);
+                vx[j][k] = v.columns[0][i0 + j];
+                vy[j][k] = v.columns[1][i0 + j];
+                vz[j][k] = v.columns[2][i0 + j];
+            }
+            a01[k] = static_cast<double>(pt[0] - pt[1]);
+            a02[k] = static_cast<double>(pt[0] - pt[2]);
+            a03[k] = static_cast<double>(pt[0] - pt[3]);
+            a12[k] = static_cast<double>(pt[1] - pt[2]);
+            a13[k] = static_cast<double>(pt[1] - pt[3]);
+            a23[k] = static_cast<double>(pt[2] - pt[3]);
+        }
+
+        /* Pass 2: evaluate (independent per query, vectorised) */
+        double* xo = x + base;
+        double* yo = y + base;
+        double* zo = z + base;
+        for (size_t k = 0; k < m; ++k)
+        {
+            double w0, w1, w2, w3;
+            series::lagrangeWeights(d[0][k], d[1][k], d[2][k], d[3][k],
+                                    a01[k], a02[k], a03[k],
+                                    a12[k], a13[k], a23[k],
+                                    w0, w1, w2, w3);
+
+            double sx = 0.0, sy = 0.0, sz = 0.0;
+            sx += vx[0][k] * w0;  sy += vy[0][k] * w0;  sz += vz[0][k] * w0;
+            sx += vx[1][k] * w1;  sy += vy[1][k] * w1;  sz += vz[1][k] * w1;
+            sx += vx[2][k] * w2;  sy += vy[2][k] * w2;  sz += vz[2][k] * w2;
+            sx += vx[3][k] * w3;  sy += vy[3][k] * w3;  sz += vz[3][k] * w3;
+
+            xo[k] = sx * v.scale;
+            yo[k] = sy * v.scale;
+            zo[k] = sz * v.scale;
+        }
+    }
+}
+
+template <typename T, typename Scheme, typename Storage>
+size_t SampleSeries<T, Scheme, Storage>::size() const
+{
+    return storage.view().count;
+}
+
+template <typename T, typename Scheme, typename Storage>
+DateTime SampleSeries<T, Scheme, Storage>::timeAt(size_t i) const
+{
+    return DateTime::fromTicks(storage.view().t[i]);
+}
+
+template <typename T, typename Scheme, typename Storage>
+T SampleSeries<T, Scheme, Storage>::valueAt(size_t i) const
+{
+    SeriesView<components> v = storage.view();
+
+    double c[components];
+    for (size_t d = 0; d < components; ++d)
+        c[d] = v.columns[d][i] * v.scale;
+    return Traits::join(c);
+}
+
+template <typename T, typename Scheme, typename Storage>
+SampleSeries<T, Scheme, Storage>
+SampleSeries<T, Scheme, Storage>::operator*(double scalar) const
+{
+    SampleSeries result = *this;
+    result.storage.scale(scalar);
+    return result;
+}
@@ -1,16 +1,26 @@
 #ifndef SATELLITE_H
 #define SATELLITE_H
 
+#include <array>
 #include "Matrix.h"
 #include "Vector.h"
 #include "Flatley.h"
+#include "HysteresisRodBank.h"
+#include "Quaternion.h"
 using namespace std;
 
-static const double mu_0 = 1.257E-6;
-
-class Satellite
+// A satellite whose hysteresis rods follow Model, one of the models of
+// HysteresisModel.h (Satellite is the inverse tangent Flatley one). The
+// definitions are in Satellite.cpp, instantiated for those models.
+template <typename Model>
+class BasicSatellite
 {
 
+public:
+    using Loop = typename Model::Loop;
+    using Rod = BasicHysteresisRod<Model>;
+    using RodBank = BasicHysteresisRodBank<Model>;
+
 private:
     Matrix momentOfInertia = {
         1, 0, 0,
@@ -18,9 +28,16 @@ private:
         0, 0, 1
     };
 
-    Vector x = {1, 0, 0};       // Orientation of x axis
-    Vector y = {0, 1, 0};       // Orientation of y axis
-    Vector z = {0, 0, 1};       // Orientation of z axis
+    // Derived from momentOfInertia once and refreshed only by
+    // setMomentOfInertia(), so stepping never inverts the tensor
+    Matrix inverseInertia = momentOfInertia;
+    Vector inverseInertiaDiagonal = {1, 1, 1};
+    bool inertiaDiagonal = true;        // tensor given in its principal frame
+    void updateInertiaCache();
+
+    // Attitude (body to inertial). The x, y, z body axes are derived
+    // from it on demand, see getOrientation()
+    Quaternion attitude;
     Vector angularVelocity = {1, 0, 0};
     Vector angularAcceleration = {1, 0, 0};
 
@@ -34,37 +51,33 @@ private:
     int numXHyst = 0;
     int numYHyst = 0;
     int numZHyst = 0;
-    Flatley hystX;
-    Flatley hystY;
-    Flatley hystZ;
-    double hystMX = 0.0,        // ... of hysteresis rods in x direction
-           hystMY = 0.0,        // ... of hysteresis rods in y direction
-           hystMZ = 0.0;        // ... of hysteresis rods in z direction
+
+    // Every rod; the first three entries are the x, y and z stacks
+    // above, further ones come from addHystRod()
+    RodBank hystRods;
+    void addAxisRods(const Loop& loop);
 
 public:
     // Constructor
-    Satellite();
-    Satellite(Matrix inMOI,
-              Vector inX,
-              Vector inY,
-              Vector inZ,
-              Vector inOmega,
-              Vector inAlpha,
-              double inBarM,
-              double inHystVol,
-              double inHystNd,
-              int inNumXHyst,
-              int inNumYHyst,
-              int inNumZHyst,
-              double hC,
-              double bR,
-              double bS,
-              double q0,
-              double p);
+    BasicSatellite();
+    BasicSatellite(Matrix inMOI,
+                   Vector inX,
+                   Vector inY,
+                   Vector inZ,
+                   Vector inOmega,
+                   Vector inAlpha,
+                   double inBarM,
+                   double inHystVol,
+                   double inHystNd,
+                   int inNumXHyst,
+                   int inNumYHyst,
+                   int inNumZHyst,
+                   const Loop& loop);
 
     // Modifiers
     void setMomentOfInertia(Matrix MOI);
     void setOrientation(Vector X, Vector Y, Vector Z);
+    void setAttitude(Quaternion q);
     void setAngularVelocity(Vector omega);
     void setAngularAcceleration(Vector alpha);
 
@@ -73,18 +86,24 @@ public:
     void setNumYHyst(int h);
     void setNumZHyst(int h);
 
-    void setHystCurve(double hC,
-                      double bR,
-                      double bS,
-                      double q0,
-                      double p);
+    // Loop of the x, y and z stacks
+    void setHystLoop(const Loop& loop);
+    // atan evaluation of the rods (Flatley::Kernel)
+    void setHystKernel(Flatley::Kernel kernel);
+    // Change in h below which the rods keep their branch
+    void setHystTolerance(double tolerance);
+    // Adds a rod (or stack of identical ones) of any axis and material
+    size_t addHystRod(const Rod& rod);
 
     // Update the hystersis values
     void updateHystM(Vector H, double timestep);
 
     // Accessors
     Matrix getMomentOfInertia() const;
-    vector<Vector> getOrientation() const;
+    Matrix getInverseMomentOfInertia() const;
+    bool isInertiaDiagonal() const;
+    array<Vector, 3> getOrientation() const;
+    Quaternion getAttitude() const;
     Vector getAngularVelocity() const;
     Vector getAngularAcceleration() const;
 
@@ -97,6 +116,7 @@ public:
     int getNumXHyst() const;
     int getNumYHyst() const;
     int getNumZHyst() const;
+    const RodBank& getHystRods() const;
 
     // Displayers
     string displayMomentOfInertia() const;
@@ -104,8 +124,17 @@ public:
     string displayAngularVelocity() const;
     string displayAngularAcceleration() const;
 
+    // Angular acceleration a torque (inertial) gives, I^-1 torque
+    Vector angularAccelerationFor(const Vector& torque) const;
+
     // Function to apply torque on the satellite
     void applyTorque(Vector torque, double timestep);
 };
 
+using Satellite = BasicSatellite<FlatleyAtan>;
+
+extern template class BasicSatellite<FlatleyAtan>;
+extern template class BasicSatellite<FlatleyDifferential>;
+extern template class BasicSatellite<JilesAtherton>;
+
 #endif
@@ -1,8 +1,11 @@
 #ifndef SIMULATION_H
 #define SIMULATION_H
 
+#include <functional>
 #include "Satellite.h"
 #include "Numerics.h"
+#include "GeomagneticField.h"
+#include "FieldCache.h"
 
 // Function to display progress bar
 string progressBar(int current, int total, const string &label);
@@ -11,15 +14,66 @@ string clearScreenString();
 
 SampleDataVector readMagFile(const string& filename);
 
-// Function to export details
-void exportParams(const Satellite& satellite, 
+// Same, reading only what a run over [startTime, stopTime] needs through
+// a bounded sliding window (see SampleDataVector::openWindow)
+SampleDataVector readMagFile(const string& filename,
+                             const DateTime& startTime,
+                             const DateTime& stopTime);
+
+// Same, through the field cache in cacheDirectory (see FieldCache): the
+// first run with this file, range and timestep interpolates the field
+// onto its time grid and stores it, later ones map the stored result
+SampleDataVector readMagFile(const string& filename,
+                             const DateTime& startTime,
+                             const DateTime& stopTime,
+                             double timestep,
+                             const string& cacheDirectory);
+
+// Field along the orbit of a position export (see OrbitField), in the
+// same units as readMagFile. The model is read from coefficientFile (an
+// IGRF table), or is the built-in one if that is empty; simulate() warns
+// when a run falls outside the model's five years
+OrbitField readOrbitField(const string& positionFile,
+                          const string& coefficientFile = "");
+
+// Same along a propagated orbit, with no field or position file
+OrbitField orbitField(const OrbitPropagator& orbit,
+                      const string& coefficientFile = "");
+
+// Function to export details. The functions taking a BasicSatellite are
+// instantiated in Simulation.cpp for the models of HysteresisModel.h
+template <typename Model>
+void exportParams(const BasicSatellite<Model>& satellite,
                   const string& outputCsvFilename);
-void printParams(const Satellite& satellite, ostream& ostring);
+template <typename Model>
+void printParams(const BasicSatellite<Model>& satellite, ostream& ostring);
 
 enum class IntegratorType
 {
-    Euler,
-    RungeKutta4
+    Euler,          // advancePhysicsStep
+    RungeKutta4,    // classical RK4 on the packed attitude state
+    DormandPrince45 // embedded 5(4) pair, steps chosen by StepControl
+};
+
+// Error control of DormandPrince45. A step is kept when the RMS over the
+// attitude state of its error estimate, each component scaled by
+// absTol + relTol |y|, is at most 1
+struct StepControl
+{
+    double relTol = 1e-6;
+    double absTol = 1e-8;
+    double minStep = 1e-4;  // s; a step this short is kept regardless
+    double maxStep = 60;    // s
+};
+
+// What an adaptive run did
+struct StepStatistics
+{
+    long accepted = 0;
+    long rejected = 0;
+    long evaluations = 0;   // of the attitude derivative
+    double smallest = 0;    // accepted step lengths (s)
+    double largest = 0;
 };
 
 struct SimulationContext
@@ -35,19 +89,62 @@ struct SimulationContext
 
     Vector hystMagField;
 
-    std::vector<Vector> orientation;
+    std::array<Vector, 3> orientation;
+
+    // This run's place in the shared field data
+    SampleCursor fieldCursor;
 
     explicit SimulationContext(const DateTime& t);
 };
 
-// Function to simulate a satellite
-void simulate(Satellite satellite,
-              SampleDataVector mag_data,
+// The run functions take either field source as Field: a field export
+// (SampleDataVector) or the field computed from the orbit (OrbitField).
+// They are instantiated in Simulation.cpp for both.
+
+// Advances the satellite by a single step of length dt
+template <typename Model, typename Field>
+void advancePhysicsStep(BasicSatellite<Model>& satellite,
+                        const Field& mag_data,
+                        SimulationContext& ctx,
+                        double dt);
+
+// Same with the chosen integrator. Both leave ctx.time for the caller
+// to move on
+template <typename Model, typename Field>
+void integrateStep(BasicSatellite<Model>& satellite,
+                   const Field& mag_data,
+                   SimulationContext& ctx,
+                   double dt,
+                   IntegratorType integrator);
+
+// Integrates with DormandPrince45 from ctx.time to stopTime. output is
+// called at ctx.time + k outputInterval (k = 0, 1, ... before stopTime)
+// with ctx holding the state interpolated there; the satellite is left
+// at the last step and ctx as advancePhysicsStep leaves it
+template <typename Model, typename Field>
+StepStatistics integrateAdaptive(
+    BasicSatellite<Model>& satellite,
+    const Field& mag_data,
+    SimulationContext& ctx,
+    const DateTime& stopTime,
+    double outputInterval,
+    const StepControl& control,
+    const std::function<void(const SimulationContext&)>& output);
+
+// Function to simulate a satellite. mag_data is only read (through the
+// run's own cursor), so concurrent runs can share one copy of it.
+// With DormandPrince45 baseTimestep is the spacing of the rows written
+// (and the first step), the steps themselves follow control, and
+// adaptiveTimestep must be false (invalid_argument otherwise)
+template <typename Model, typename Field>
+void simulate(BasicSatellite<Model> satellite,
+              const Field& mag_data,
               DateTime startTime,
               DateTime stopTime,
               double baseTimestep,
               std::string filename,
               IntegratorType integrator,
-              bool adaptiveTimestep);
+              bool adaptiveTimestep,
+              const StepControl& control = StepControl());
 
 #endif
@@ -2,42 +2,103 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
-#include <vector>
+#include <array>
 #include <cstddef>
 #include <string>
+#include <cmath>
 #include <initializer_list>
+#include <type_traits>
+#include "Debug.h"
 using namespace std;
 
-class Vector
+class Vector;
+
+// -- -- -- -- -- -- -- //
+// EXPRESSION TEMPLATES //
+// -- -- -- -- -- -- -- //
+//
+// Sums, differences and scalings of vectors do not compute anything when
+// they are written; they return a small node that remembers its operands.
+// The whole chain is evaluated element by element, in one pass, when it
+// is assigned to a Vector, so expressions such as
+//      (a + b * 2.0 + c * 2.0 + d) / 6.0
+// produce no intermediate Vector objects. Everything is constexpr.
+
+template <typename E>
+class VectorExpr
+{
+public:
+    constexpr const E& derived() const
+    {
+        return static_cast<const E&>(*this);
+    }
+
+    // Evaluates the expression into a concrete Vector
+    constexpr Vector eval() const;
+
+    double magnitude() const;
+    Vector direction() const;
+};
+
+// Leaves (Vector) are held by reference, inner nodes by value, so an
+// expression must be consumed within the statement that builds it.
+template <typename E>
+struct VectorOperand { using type = E; };
+
+template <>
+struct VectorOperand<Vector> { using type = const Vector&; };
+
+template <typename E>
+using VectorOperandT = typename VectorOperand<E>::type;
+
+
+// Fixed size 3D vector. Storage is inline (no heap), so the type is
+// trivially copyable and every operator below compiles down to a
+// handful of register operations.
+class Vector : public VectorExpr<Vector>
 {
 private:
-    vector<double> data;
+    array<double, 3> data{};
 
-    void checkBounds(size_t index) const;
+    constexpr void checkBounds(size_t index) const;
+
+    // Error paths are kept out of line so the hot accessors stay small
+    [[noreturn]] static void throwOutOfRange();
+    [[noreturn]] static void throwBadSize();
+    [[noreturn]] static void throwZeroNorm();
 
 public:
     // Constructors
-    Vector();
-    Vector(initializer_list<double> values);
+    constexpr Vector() = default;
+    constexpr Vector(initializer_list<double> values);
+    template <typename E>
+    constexpr Vector(const VectorExpr<E>& expr);
+
+    // Assignment from an expression (evaluated before it is stored, so
+    // the vector may appear on both sides)
+    template <typename E>
+    constexpr Vector& operator=(const VectorExpr<E>& expr);
 
     // return an element of the vector
-    double& operator[](size_t index);
-    const double& operator[](size_t index) const;
+    constexpr double& operator[](size_t index);
+    constexpr const double& operator[](size_t index) const;
 
     // return the size of the vector
-    size_t size() const;
+    constexpr size_t size() const;
 
     // return the value of a particular index of the vector
-    double at(size_t index) const;
+    constexpr double at(size_t index) const;
 
-    // Operators
-    Vector operator*(double scalar) const;        // Scale
-    Vector operator/(double scalar) const;        // Scale
-    double operator*(const Vector& other) const;  // Dot Product
-    Vector operator^(const Vector& other) const;  // Cross Product
-    Vector operator+(const Vector& other) const;  // Vector Addition
-    Vector operator-(const Vector& other) const;  // Vector Addition
-    Vector& operator+=(const Vector& other);      // Vector Addition
+    // Operators (see below the class for the binary ones)
+    //  v * s, s * v, v / s       : Scale
+    //  v * w                     : Dot Product
+    //  v ^ w                     : Cross Product
+    //  v + w, v - w              : Vector Addition / Subtraction
+    template <typename E>
+    constexpr Vector& operator+=(const VectorExpr<E>& other);
+    template <typename E>
+    constexpr Vector& operator-=(const VectorExpr<E>& other);
+    constexpr Vector& operator*=(double scalar);
 
     // Functions to get characteristic values of a vector
     double magnitude() const;       // returns magnitude
@@ -47,4 +108,255 @@ public:
     string display() const;
 };
 
+
+// -- -- -- -- -- - //
+// EXPRESSION NODES //
+// -- -- -- -- -- - //
+
+template <typename L, typename R>
+class VectorSum : public VectorExpr<VectorSum<L, R>>
+{
+public:
+    constexpr VectorSum(const L& lhs, const R& rhs) : lhs(lhs), rhs(rhs) {}
+    constexpr double operator[](size_t i) const { return lhs[i] + rhs[i]; }
+
+private:
+    VectorOperandT<L> lhs;
+    VectorOperandT<R> rhs;
+};
+
+template <typename L, typename R>
+class VectorDifference : public VectorExpr<VectorDifference<L, R>>
+{
+public:
+    constexpr VectorDifference(const L& lhs, const R& rhs)
+        : lhs(lhs), rhs(rhs) {}
+    constexpr double operator[](size_t i) const { return lhs[i] - rhs[i]; }
+
+private:
+    VectorOperandT<L> lhs;
+    VectorOperandT<R> rhs;
+};
+
+template <typename E>
+class VectorScaled : public VectorExpr<VectorScaled<E>>
+{
+public:
+    constexpr VectorScaled(const E& expr, double scalar)
+        : expr(expr), scalar(scalar) {}
+    constexpr double operator[](size_t i) const { return expr[i] * scalar; }
+
+private:
+    VectorOperandT<E> expr;
+    double scalar;
+};
+
+template <typename E>
+class VectorQuotient : public VectorExpr<VectorQuotient<E>>
+{
+public:
+    constexpr VectorQuotient(const E& expr, double scalar)
+        : expr(expr), scalar(scalar) {}
+    constexpr double operator[](size_t i) const { return expr[i] / scalar; }
+
+private:
+    VectorOperandT<E> expr;
+    double scalar;
+};
+
+
+// -- -- --- //
+// OPERATORS //
+// -- -- --- //
+
+template <typename L, typename R>
+constexpr VectorSum<L, R> operator+(const VectorExpr<L>& lhs,
+                                    const VectorExpr<R>& rhs)
+{
+    return VectorSum<L, R>(lhs.derived(), rhs.derived());
+}
+
+template <typename L, typename R>
+constexpr VectorDifference<L, R> operator-(const VectorExpr<L>& lhs,
+                                           const VectorExpr<R>& rhs)
+{
+    return VectorDifference<L, R>(lhs.derived(), rhs.derived());
+}
+
+template <typename E>
+constexpr VectorScaled<E> operator*(const VectorExpr<E>& expr, double scalar)
+{
+    return VectorScaled<E>(expr.derived(), scalar);
+}
+
+template <typename E>
+constexpr VectorScaled<E> operator*(double scalar, const VectorExpr<E>& expr)
+{
+    return VectorScaled<E>(expr.derived(), scalar);
+}
+
+template <typename E>
+constexpr VectorQuotient<E> operator/(const VectorExpr<E>& expr,
+                                      double scalar)
+{
+    return VectorQuotient<E>(expr.derived(), scalar);
+}
+
+// Dot Product
+template <typename L, typename R>
+constexpr double operator*(const VectorExpr<L>& lhs, const VectorExpr<R>& rhs)
+{
+    const L& a = lhs.derived();
+    const R& b = rhs.derived();
+    return a[0] * b[0]
+         + a[1] * b[1]
+         + a[2] * b[2];
+}
+
+// Cross Product (every element reads two elements of each operand, so
+// the operands are evaluated once up front)
+template <typename L, typename R>
+constexpr Vector operator^(const VectorExpr<L>& lhs, const VectorExpr<R>& rhs)
+{
+    const Vector a = lhs.derived();
+    const Vector b = rhs.derived();
+    return Vector{
+        a[1] * b[2] - a[2] * b[1],
+        a[2] * b[0] - a[0] * b[2],
+        a[0] * b[1] - a[1] * b[0]
+    };
+}
+
+
+// -- -- -- -- --- //
+// ACCESS ELEMENTS //
+// -- -- -- -- --- //
+
+constexpr void Vector::checkBounds(size_t index) const
+{
+    if (index >= 3)
+        throwOutOfRange();
+}
+
+constexpr Vector::Vector(initializer_list<double> values)
+{
+    if (values.size() != 3)
+        throwBadSize();
+
+    size_t index = 0;
+    for (double value : values)
+        data[index++] = value;
+}
+
+template <typename E>
+constexpr Vector::Vector(const VectorExpr<E>& expr)
+{
+    const E& e = expr.derived();
+    data[0] = e[0];
+    data[1] = e[1];
+    data[2] = e[2];
+}
+
+template <typename E>
+constexpr Vector& Vector::operator=(const VectorExpr<E>& expr)
+{
+    const Vector result(expr);
+    data = result.data;
+    return *this;
+}
+
+// operator[] is range checked only under MAGSIMS_BOUNDS_CHECK (see
+// Debug.h); at() always is
+constexpr double& Vector::operator[](size_t index)
+{
+#if MAGSIMS_BOUNDS_CHECK
+    checkBounds(index);
+#endif
+    return data[index];
+}
+
+constexpr const double& Vector::operator[](size_t index) const
+{
+#if MAGSIMS_BOUNDS_CHECK
+    checkBounds(index);
+#endif
+    return data[index];
+}
+
+constexpr double Vector::at(size_t index) const
+{
+    checkBounds(index);
+    return data[index];
+}
+
+constexpr size_t Vector::size() const
+{
+    return 3;
+}
+
+template <typename E>
+constexpr Vector& Vector::operator+=(const VectorExpr<E>& other)
+{
+    const Vector rhs(other);
+    for (size_t i = 0; i < 3; ++i)
+        data[i] += rhs.data[i];
+    return *this;
+}
+
+template <typename E>
+constexpr Vector& Vector::operator-=(const VectorExpr<E>& other)
+{
+    const Vector rhs(other);
+    for (size_t i = 0; i < 3; ++i)
+        data[i] -= rhs.data[i];
+    return *this;
+}
+
+constexpr Vector& Vector::operator*=(double scalar)
+{
+    for (size_t i = 0; i < 3; ++i)
+        data[i] *= scalar;
+    return *this;
+}
+
+inline double Vector::magnitude() const
+{
+    return sqrt(
+        data[0] * data[0] +
+        data[1] * data[1] +
+        data[2] * data[2]
+    );
+}
+
+inline Vector Vector::direction() const
+{
+    double mag = magnitude();
+    if (mag == 0.0)
+        throwZeroNorm();
+    return (*this) * (1.0 / mag);
+}
+
+
+// -- -- -- -- -- -- -- -- //
+// EXPRESSION EVALUATION   //
+// -- -- -- -- -- -- -- -- //
+
+template <typename E>
+constexpr Vector VectorExpr<E>::eval() const
+{
+    return Vector(*this);
+}
+
+template <typename E>
+inline double VectorExpr<E>::magnitude() const
+{
+    return eval().magnitude();
+}
+
+template <typename E>
+inline Vector VectorExpr<E>::direction() const
+{
+    return eval().direction();
+}
+
 #endif // VECTOR_H
@@ -0,0 +1,106 @@
+#include "BinarySeries.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    uint64_t alignUp(uint64_t offset)
+    {
+        return (offset + 63) / 64 * 64;
+    }
+}
+
+BinarySeriesView viewBinarySeries(const MappedFile& file)
+{
+    if (file.size() < sizeof(BinarySeriesHeader))
+        throw runtime_error("Not a binary series file: " + file.name());
+
+    BinarySeriesHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+
+    if (memcmp(header.magic, binarySeriesMagic, sizeof(header.magic)) != 0)
+        throw runtime_error("Not a binary series file: " + file.name());
+    if (header.version != binarySeriesVersion)
+        throw runtime_error("Unsupported binary series version in "
+                            + file.name() + " (rewrite it with csv_to_bin)");
+    if (header.components != 3)
+        throw runtime_error("Binary series is not 3-component: "
+                            + file.name());
+
+    uint64_t timeEnd  = header.timeOffset + header.count * sizeof(int64_t);
+    uint64_t valueEnd = header.valueOffset
+                      + header.count * 3 * sizeof(double);
+    if (timeEnd > file.size() || valueEnd > file.size()
+        || header.timeOffset % alignof(int64_t) != 0
+        || header.valueOffset % alignof(double) != 0)
+        throw runtime_error("Truncated binary series file: " + file.name());
+
+    BinarySeriesView view;
+    view.count  = static_cast<size_t>(header.count);
+    view.ticks  = reinterpret_cast<const int64_t*>(
+                      file.data() + header.timeOffset);
+    view.x      = reinterpret_cast<const double*>(
+                      file.data() + header.valueOffset);
+    view.y      = view.x + view.count;
+    view.z      = view.y + view.count;
+    view.sorted = header.sorted != 0;
+    view.gridStep = header.gridStep > 0 ? header.gridStep : 0;
+    return view;
+}
+
+bool isBinarySeries(const string& filename)
+{
+    ifstream file(filename, ios::binary);
+    char magic[8] = {};
+    if (!file.read(magic, sizeof(magic)))
+        return false;
+    return memcmp(magic, binarySeriesMagic, sizeof(magic)) == 0;
+}
+
+void writeBinarySeries(const string& filename,
+                       size_t count,
+                       const int64_t* ticks,
+                       const double* x,
+                       const double* y,
+                       const double* z,
+                       bool sorted,
+                       int64_t gridStep)
+{
+    BinarySeriesHeader header = {};
+    memcpy(header.magic, binarySeriesMagic, sizeof(header.magic));
+    header.version     = binarySeriesVersion;
+    header.components  = 3;
+    header.count       = count;
+    header.timeOffset  = alignUp(sizeof(BinarySeriesHeader));
+    header.valueOffset = alignUp(header.timeOffset
+                                 + count * sizeof(int64_t));
+    header.sorted      = sorted ? 1 : 0;
+    header.gridStep    = gridStep;
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (!file)
+        throw runtime_error("Cannot create binary series file: " + filename);
+
+    vector<char> padding(64, 0);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding.data(), header.timeOffset - sizeof(header));
+    file.write(reinterpret_cast<const char*>(ticks),
+               count * sizeof(int64_t));
+    file.write(padding.data(),
+               header.valueOffset - header.timeOffset
+               - count * sizeof(int64_t));
+    for (const double* plane : {x, y, z})
+        file.write(reinterpret_cast<const char*>(plane),
+                   count * sizeof(double));
+
+    // The last flush happens on close; a failure there (disk full) is
+    // only seen after it
+    file.close();
+    if (!file)
+        throw runtime_error("Failed writing binary series file: " + filename);
+}
@@ -0,0 +1,447 @@
+#include "CsvReader.h"
+#include "DateTime.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    // Chunks smaller than this are not worth a thread
+    const size_t minChunkBytes = 1 << 20;
+
+    struct Field
+    {
+        const char* begin;
+        const char* end;
+    };
+
+    const char* lineEnd(const char* p, const char* end)
+    {
+        const void* nl = memchr(p, '\n', end - p);
+        return nl ? static_cast<const char*>(nl) : end;
+    }
+
+    // Splits one line into fields, keeping only the wanted columns
+    // (wanted[k] is the column of output slot k). Returns false if the
+    // line has too few columns.
+    bool splitLine(const char* begin, const char* end,
+                   const vector<size_t>& wanted, size_t lastWanted,
+                   vector<Field>& fields)
+    {
+        if (end > begin && end[-1] == '\r')
+            --end;
+
+        size_t column = 0;
+        const char* p = begin;
+        while (column <= lastWanted)
+        {
+            const char* comma = static_cast<const char*>(
+                memchr(p, ',', end - p));
+            const char* fieldEnd = comma ? comma : end;
+
+            for (size_t k = 0; k < wanted.size(); ++k)
+                if (wanted[k] == column)
+                    fields[k] = {p, fieldEnd};
+
+            ++column;
+            if (!comma)
+                break;
+            p = comma + 1;
+        }
+        return column > lastWanted;
+    }
+
+    bool parseNumber(Field field, double& value)
+    {
+        const char* b = field.begin;
+        const char* e = field.end;
+        while (b < e && (*b == ' ' || *b == '"'))
+            ++b;
+        while (e > b && (e[-1] == ' ' || e[-1] == '"'))
+            --e;
+        if (b < e && *b == '+')
+            ++b;
+
+        auto result = from_chars(b, e, value);
+        return result.ec == errc() && result.ptr == e;
+    }
+
+    // Parses one line into its time stamp and values. Returns false for
+    // a malformed line.
+    bool parseRow(const char* p, const char* eol,
+                  const vector<size_t>& wanted, size_t lastWanted,
+                  vector<Field>& fields, double* row, int64_t& ticks)
+    {
+        size_t columns = wanted.size() - 1;
+
+        bool ok = splitLine(p, eol, wanted, lastWanted, fields);
+        for (size_t k = 0; ok && k < columns; ++k)
+            ok = parseNumber(fields[k + 1], row[k]);
+
+        if (ok){
+            try{
+                ticks = DateTime(fields[0].begin,
+                                 fields[0].end - fields[0].begin).ticks();
+            }
+            catch (...){
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    bool blankLine(const char* p, const char* eol)
+    {
+        return eol == p || (eol - p == 1 && *p == '\r');
+    }
+
+    void parseChunk(const char* begin, const char* end,
+                    const vector<size_t>& wanted, size_t lastWanted,
+                    CsvSeries& out)
+    {
+        size_t columns = wanted.size() - 1;
+        vector<Field> fields(wanted.size());
+        vector<double> row(columns);
+
+        // Sizing the output from the first row's length
+        size_t firstLine = lineEnd(begin, end) - begin + 1;
+        size_t estimate = (end - begin) / max<size_t>(firstLine, 1) + 1;
+        out.ticks.reserve(estimate);
+        out.values.reserve(estimate * columns);
+
+        const char* p = begin;
+        while (p < end)
+        {
+            const char* eol = lineEnd(p, end);
+            const char* next = eol < end ? eol + 1 : end;
+
+            if (blankLine(p, eol)){
+                p = next;
+                continue;
+            }
+
+            int64_t ticks = 0;
+            if (parseRow(p, eol, wanted, lastWanted, fields, row.data(),
+                         ticks)){
+                out.ticks.push_back(ticks);
+                out.values.insert(out.values.end(), row.begin(), row.end());
+            } else {
+                ++out.skipped;
+            }
+            p = next;
+        }
+    }
+
+    // Splits the header line and resolves the wanted columns (time
+    // first). Returns the start of the first data line.
+    const char* readHeader(const char* begin, const char* end,
+                           const string& timeColumn,
+                           const vector<string>& valueColumns,
+                           vector<size_t>& wanted, size_t& lastWanted)
+    {
+        const char* headerEnd = lineEnd(begin, end);
+        vector<string> header;
+        {
+            const char* stop = headerEnd;
+            if (stop > begin && stop[-1] == '\r')
+                --stop;
+            const char* p = begin;
+            while (p <= stop)
+            {
+                const char* comma = static_cast<const char*>(
+                    memchr(p, ',', stop - p));
+                const char* fieldEnd = comma ? comma : stop;
+                header.emplace_back(p, fieldEnd);
+                if (!comma)
+                    break;
+                p = comma + 1;
+            }
+        }
+
+        auto findColumn = [&header](const string& name){
+            for (size_t i = 0; i < header.size(); ++i)
+                if (header[i] == name)
+                    return i;
+            throw runtime_error("Column not found: " + name);
+        };
+
+        wanted.clear();
+        wanted.push_back(findColumn(timeColumn));
+        for (const auto& name : valueColumns)
+            wanted.push_back(findColumn(name));
+        lastWanted = *max_element(wanted.begin(), wanted.end());
+
+        return headerEnd < end ? headerEnd + 1 : end;
+    }
+
+    unique_ptr<MappedFile> openCsv(const string& filename)
+    {
+        try{
+            return make_unique<MappedFile>(filename);
+        }
+        catch (const runtime_error&){
+            throw runtime_error("Cannot open CSV file");
+        }
+    }
+}
+
+CsvSeries readCsvSeries(const string& filename,
+                        const string& timeColumn,
+                        const vector<string>& valueColumns,
+                        unsigned threads)
+{
+    unique_ptr<MappedFile> file = openCsv(filename);
+
+    const char* begin = file->data();
+    const char* end = begin + file->size();
+
+    vector<size_t> wanted;
+    size_t lastWanted = 0;
+    const char* body = readHeader(begin, end, timeColumn, valueColumns,
+                                  wanted, lastWanted);
+
+    /* Newline aligned chunks */
+    size_t bodyBytes = end - body;
+
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+    size_t numChunks = min<size_t>(threads,
+                                   max<size_t>(1, bodyBytes / minChunkBytes));
+
+    vector<const char*> bounds = {body};
+    for (size_t c = 1; c < numChunks; ++c)
+    {
+        const char* guess = body + bodyBytes * c / numChunks;
+        guess = max(guess, bounds.back());
+        const char* eol = lineEnd(guess, end);
+        bounds.push_back(eol < end ? eol + 1 : end);
+    }
+    bounds.push_back(end);
+
+    vector<CsvSeries> parts(numChunks);
+    for (auto& part : parts)
+        part.columns = valueColumns.size();
+
+    if (numChunks == 1){
+        parseChunk(bounds[0], bounds[1], wanted, lastWanted, parts[0]);
+    } else {
+        vector<thread> workers;
+        for (size_t c = 0; c < numChunks; ++c)
+            workers.emplace_back(parseChunk, bounds[c], bounds[c + 1],
+                                 cref(wanted), lastWanted, ref(parts[c]));
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    /* Concatenating in file order */
+    CsvSeries result = std::move(parts[0]);
+    for (size_t c = 1; c < numChunks; ++c)
+    {
+        result.ticks.insert(result.ticks.end(),
+                            parts[c].ticks.begin(), parts[c].ticks.end());
+        result.values.insert(result.values.end(),
+                             parts[c].values.begin(), parts[c].values.end());
+        result.skipped += parts[c].skipped;
+    }
+
+    if (result.skipped > 0)
+        cerr << "Skipped " << result.skipped
+             << " malformed line(s) in " << filename << '\n';
+
+    return result;
+}
+
+
+/* ================= CsvStream ================= */
+
+namespace
+{
+    const char* nextLine(const char* p, const char* end)
+    {
+        const char* eol = lineEnd(p, end);
+        return eol < end ? eol + 1 : end;
+    }
+}
+
+CsvStream::CsvStream(const string& filename,
+                     const string& timeColumn,
+                     const vector<string>& valueColumns,
+                     int64_t startTicks,
+                     int64_t stopTicks,
+                     size_t blockRows,
+                     size_t margin)
+    : file(openCsv(filename)),
+      stopTicks(stopTicks),
+      blockRows(max<size_t>(blockRows, 1)),
+      margin(margin)
+{
+    const char* begin = file->data();
+    end = begin + file->size();
+    const char* body = readHeader(begin, end, timeColumn, valueColumns,
+                                  wanted, lastWanted);
+    pending.columns = valueColumns.size();
+
+    vector<Field> fields(wanted.size());
+    vector<double> row(valueColumns.size());
+
+    // First parseable line at or after p and before limit
+    auto probe = [&](const char* p, const char* limit, int64_t& ticks){
+        while (p < limit){
+            const char* eol = lineEnd(p, end);
+            if (!blankLine(p, eol)
+                && parseRow(p, eol, wanted, lastWanted, fields, row.data(),
+                            ticks))
+                return p;
+            p = nextLine(p, end);
+        }
+        return limit;
+    };
+
+    /* Binary search for the first line with time >= startTicks; lo and
+       hi are always line starts */
+    const char* lo = body;
+    const char* hi = end;
+    while (lo < hi)
+    {
+        const char* mid = lo + (hi - lo) / 2;
+        const char* line = (mid[-1] == '\n') ? mid : nextLine(mid, end);
+        if (line >= hi)
+            line = lo;
+
+        int64_t ticks = 0;
+        const char* found = probe(line, hi, ticks);
+        if (found == hi)
+            hi = line;
+        else if (ticks < startTicks)
+            lo = nextLine(found, end);
+        else
+            hi = line;
+    }
+
+    // Backing up margin lines for the interpolation stencil
+    const char* first = lo;
+    for (size_t k = 0; k < margin && first > body; ++k)
+    {
+        const char* p = first - 1;
+        while (p > body && p[-1] != '\n')
+            --p;
+        first = p;
+    }
+
+    // Nothing before the range is needed again
+    file->release(0, first - begin);
+
+    cursor = first;
+    worker = thread(&CsvStream::produce, this);
+}
+
+CsvStream::~CsvStream()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+void CsvStream::produce()
+{
+    size_t columns = wanted.size() - 1;
+    vector<Field> fields(wanted.size());
+    vector<double> row(columns);
+    size_t afterStop = 0;
+    bool pastStop = false;  // the margin after stopTicks is read
+    size_t skipped = 0;
+
+    try{
+        bool last = false;
+        while (!last)
+        {
+            CsvSeries block;
+            block.columns = columns;
+            block.ticks.reserve(blockRows);
+            block.values.reserve(blockRows * columns);
+
+            const char* blockStart = cursor;
+            while (cursor < end && block.rows() < blockRows && !pastStop)
+            {
+                const char* eol = lineEnd(cursor, end);
+                const char* next = eol < end ? eol + 1 : end;
+
+                int64_t ticks = 0;
+                if (blankLine(cursor, eol)){
+                    // nothing to parse
+                } else if (parseRow(cursor, eol, wanted, lastWanted, fields,
+                                    row.data(), ticks)){
+                    // With no margin the first row past stopTicks only
+                    // ends the range
+                    if (ticks > stopTicks && afterStop >= margin){
+                        pastStop = true;
+                        break;
+                    }
+                    block.ticks.push_back(ticks);
+                    block.values.insert(block.values.end(),
+                                        row.begin(), row.end());
+                    if (ticks > stopTicks)
+                        pastStop = ++afterStop >= margin;
+                } else {
+                    ++block.skipped;
+                }
+                cursor = next;
+            }
+            last = cursor >= end || pastStop;
+            skipped += block.skipped;
+
+            // The rows now live in the block, not in the page cache
+            file->release(blockStart - file->data(), cursor - blockStart);
+
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [this]{ return !hasPending || stopping; });
+            if (stopping)
+                return;
+            pending = std::move(block);
+            hasPending = true;
+            finished = last;
+            guard.unlock();
+            changed.notify_all();
+        }
+    }
+    catch (...){
+        lock_guard<mutex> guard(lock);
+        error = current_exception();
+        finished = true;
+    }
+    changed.notify_all();
+
+    if (skipped > 0)
+        cerr << "Skipped " << skipped
+             << " malformed line(s) in " << file->name() << '\n';
+}
+
+bool CsvStream::next(CsvSeries& block)
+{
+    unique_lock<mutex> guard(lock);
+    changed.wait(guard, [this]{ return hasPending || finished; });
+
+    if (error)
+        rethrow_exception(error);
+    if (!hasPending)
+        return false;
+
+    block = std::move(pending);
+    pending = CsvSeries();
+    pending.columns = block.columns;
+    hasPending = false;
+    guard.unlock();
+    changed.notify_all();
+    return true;
+}
@@ -1,37 +1,217 @@
 #include "DateTime.h"
 #include <chrono>
-#include <sstream>
-#include <iomanip>
-#include <ctime>
+#include <cstring>
+#include <stdexcept>
 using namespace std;
 
-DateTime::DateTime(){
-    tp = parseDateTime("01 Jan 2000 00:00:00.000");
+namespace
+{
+    const char* const months[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+
+    const int64_t nsPerSecond = 1000000000;
+    const int64_t nsPerDay    = 86400 * nsPerSecond;
+
+    // Days since 1970-01-01 of a proleptic Gregorian date
+    // (H. Hinnant's days_from_civil)
+    int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+    {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    // Inverse of daysFromCivil
+    void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d)
+    {
+        z += 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524
+                              - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+    }
+
+    [[noreturn]] void badTime(const char* begin, const char* end)
+    {
+        throw invalid_argument("Invalid DateTime: " + string(begin, end));
+    }
+
+    // Reads 1+ digits, at most maxDigits
+    int64_t readNumber(const char*& p, const char* end, int maxDigits,
+                       const char* begin)
+    {
+        int64_t value = 0;
+        int digits = 0;
+        while (p < end && *p >= '0' && *p <= '9' && digits < maxDigits){
+            value = value * 10 + (*p - '0');
+            ++p;
+            ++digits;
+        }
+        if (digits == 0)
+            badTime(begin, end);
+        return value;
+    }
+
+    void expect(const char*& p, const char* end, char c, const char* begin)
+    {
+        if (p >= end || *p != c)
+            badTime(begin, end);
+        ++p;
+    }
+
+    // Consecutive rows almost always share the date, so the parsed
+    // "D Mon YYYY " prefix and the formatted day are cached per thread
+    struct ParseCache
+    {
+        char prefix[16];
+        size_t length = 0;
+        int64_t day = 0;
+    };
+    thread_local ParseCache parseCache;
+
+    struct FormatCache
+    {
+        int64_t day = INT64_MIN;
+        char prefix[12];        // "DD Mon YYYY "
+    };
+    thread_local FormatCache formatCache;
 }
 
+DateTime::DateTime()
+    : tp(std::chrono::seconds(946684800))     // 01 Jan 2000 00:00:00
+{}
+
 DateTime::DateTime(const std::string &time_str){
-    tp = parseDateTime(time_str);
+    tp = parseDateTime(time_str.data(), time_str.data() + time_str.size());
+}
+
+DateTime::DateTime(const char *time_str, size_t length){
+    tp = parseDateTime(time_str, time_str + length);
 }
 
 std::chrono::system_clock::time_point
-DateTime::parseDateTime(const std::string &time_str){
-    std::tm tm = {};
-    std::istringstream ss(time_str);
-    ss >> std::get_time(&tm, "%d %b %Y %H:%M:%S");
-    time_t time = std::mktime(&tm);
-    return std::chrono::system_clock::from_time_t(time);
+DateTime::parseDateTime(const char *begin, const char *end){
+    // Trimming blanks and quotes
+    while (begin < end && (*begin == ' ' || *begin == '"'))
+        ++begin;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '"'
+                           || end[-1] == '\r'))
+        --end;
+
+    const char* p = begin;
+
+    /* Date prefix "D Mon YYYY " (cached) */
+    const char* timeStart = nullptr;
+    {
+        const char* space = static_cast<const char*>(memchr(p, ' ', end - p));
+        if (space)
+            space = static_cast<const char*>(
+                memchr(space + 1, ' ', end - space - 1));
+        if (space)
+            space = static_cast<const char*>(
+                memchr(space + 1, ' ', end - space - 1));
+        if (!space)
+            badTime(begin, end);
+        timeStart = space + 1;
+    }
+
+    int64_t day;
+    size_t prefixLength = timeStart - p;
+    ParseCache& cache = parseCache;
+    if (prefixLength == cache.length
+        && memcmp(p, cache.prefix, prefixLength) == 0){
+        day = cache.day;
+        p = timeStart;
+    } else {
+        int64_t mday = readNumber(p, end, 2, begin);
+        expect(p, end, ' ', begin);
+
+        if (end - p < 3)
+            badTime(begin, end);
+        unsigned month = 0;
+        for (unsigned i = 0; i < 12; ++i)
+            if (memcmp(p, months[i], 3) == 0)
+                month = i + 1;
+        if (month == 0)
+            badTime(begin, end);
+        p += 3;
+        expect(p, end, ' ', begin);
+
+        int64_t year = readNumber(p, end, 4, begin);
+        expect(p, end, ' ', begin);
+
+        if (mday < 1 || mday > 31)
+            badTime(begin, end);
+        day = daysFromCivil(year, month, static_cast<unsigned>(mday));
+
+        if (prefixLength <= sizeof(cache.prefix)){
+            memcpy(cache.prefix, timeStart - prefixLength, prefixLength);
+            cache.length = prefixLength;
+            cache.day = day;
+        }
+    }
+
+    /* Time of day "HH:MM:SS[.fff...]" */
+    int64_t hour = readNumber(p, end, 2, begin);
+    expect(p, end, ':', begin);
+    int64_t minute = readNumber(p, end, 2, begin);
+    expect(p, end, ':', begin);
+    int64_t second = readNumber(p, end, 2, begin);
+
+    int64_t fraction = 0;
+    if (p < end && *p == '.'){
+        ++p;
+        int64_t scale = nsPerSecond;
+        while (p < end && *p >= '0' && *p <= '9'){
+            if (scale > 1){
+                scale /= 10;
+                fraction += (*p - '0') * scale;
+            }
+            ++p;
+        }
+    }
+    if (p != end || hour > 23 || minute > 59 || second > 60)
+        badTime(begin, end);
+
+    int64_t ns = day * nsPerDay
+               + ((hour * 60 + minute) * 60 + second) * nsPerSecond
+               + fraction;
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::nanoseconds(ns)
+        )
+    );
 }
 
 std::string DateTime::toString() const{
-    std::time_t t = std::chrono::system_clock::to_time_t(tp);
-    char buffer[100];
-    std::strftime(
-        buffer, 
-        sizeof(buffer), 
-        "%d %b %Y %H:%M:%S", 
-        std::localtime(&t)
-    );
-    return buffer;
+    // Same as display() without the milliseconds
+    char buffer[formatLength];
+    size_t n = format(buffer);
+    return std::string(buffer, n - 4);
+}
+
+int64_t DateTime::ticks() const{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        tp.time_since_epoch()
+    ).count();
+}
+
+DateTime DateTime::fromTicks(int64_t ticks){
+    return DateTime(std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::nanoseconds(ticks)
+        )
+    ));
 }
 
 bool DateTime::operator<(const DateTime &other) const{
@@ -60,35 +240,64 @@ DateTime DateTime::operator+(double seconds) const
     return result;
 }
 
-std::string DateTime::display() const{
-    // Convert time_point to time_t
-    std::time_t time_t_format = std::chrono::system_clock::to_time_t(tp);
+size_t DateTime::format(char *buffer) const{
+    int64_t ns = ticks();
+    int64_t day = ns / nsPerDay;
+    int64_t rem = ns % nsPerDay;
+    if (rem < 0){
+        rem += nsPerDay;
+        --day;
+    }
 
-    // Extract fractional seconds
-    auto duration_since_epoch = tp.time_since_epoch();
-    auto milliseconds = 
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            duration_since_epoch
-        ) % 1000;
+    // "DD Mon YYYY " only changes once a day
+    FormatCache& cache = formatCache;
+    if (day != cache.day){
+        int64_t year;
+        unsigned month, mday;
+        civilFromDays(day, year, month, mday);
 
-    // Convert to tm (broken-down time)
-    std::tm tm_struct = *std::localtime(&time_t_format);
+        char* q = cache.prefix;
+        *q++ = static_cast<char>('0' + mday / 10);
+        *q++ = static_cast<char>('0' + mday % 10);
+        *q++ = ' ';
+        memcpy(q, months[month - 1], 3);
+        q += 3;
+        *q++ = ' ';
+        int64_t y = year % 10000;
+        *q++ = static_cast<char>('0' + y / 1000);
+        *q++ = static_cast<char>('0' + y / 100 % 10);
+        *q++ = static_cast<char>('0' + y / 10 % 10);
+        *q++ = static_cast<char>('0' + y % 10);
+        *q++ = ' ';
+        cache.day = day;
+    }
+    memcpy(buffer, cache.prefix, sizeof(cache.prefix));
 
-    // Month names
-    static const char* months[] = {
-        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
-        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
-    };
+    int64_t ms = rem / 1000000;
+    int64_t seconds = ms / 1000;
+    unsigned h  = static_cast<unsigned>(seconds / 3600);
+    unsigned m  = static_cast<unsigned>(seconds / 60 % 60);
+    unsigned s  = static_cast<unsigned>(seconds % 60);
+    unsigned f  = static_cast<unsigned>(ms % 1000);
+
+    char* q = buffer + sizeof(cache.prefix);
+    *q++ = static_cast<char>('0' + h / 10);
+    *q++ = static_cast<char>('0' + h % 10);
+    *q++ = ':';
+    *q++ = static_cast<char>('0' + m / 10);
+    *q++ = static_cast<char>('0' + m % 10);
+    *q++ = ':';
+    *q++ = static_cast<char>('0' + s / 10);
+    *q++ = static_cast<char>('0' + s % 10);
+    *q++ = '.';
+    *q++ = static_cast<char>('0' + f / 100);
+    *q++ = static_cast<char>('0' + f / 10 % 10);
+    *q++ = static_cast<char>('0' + f % 10);
 
-    std::ostringstream oss;
-    oss << std::setfill('0')
-        << std::setw(2) << tm_struct.tm_mday << " "
-        << months[tm_struct.tm_mon] << " "
-        << (tm_struct.tm_year + 1900) << " "
-        << std::setw(2) << tm_struct.tm_hour << ":"
-        << std::setw(2) << tm_struct.tm_min << ":"
-        << std::setw(2) << tm_struct.tm_sec << "."
-        << std::setw(3) << milliseconds.count();
-
-    return oss.str();
+    return q - buffer;
+}
+
+std::string DateTime::display() const{
+    char buffer[formatLength];
+    return std::string(buffer, format(buffer));
 }
@@ -0,0 +1,196 @@
+#include "FieldCache.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "BinarySeries.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+
+/* ================= Shared helpers ================= */
+
+namespace
+{
+    // Bump when the grid or the interpolation changes, so that entries
+    // written by older builds are not reused
+    const int cacheFormat = 1;
+
+    // Query times per batch call while building
+    const size_t buildChunk = 4096;
+
+    // One build at a time per entry in a process, so threads asking for
+    // the same missing entry build it once while other entries build
+    // alongside. The locks live as long as the process
+    mutex& buildLock(const string& entry)
+    {
+        static mutex tableLock;
+        static unordered_map<string, unique_ptr<mutex>> locks;
+        lock_guard<mutex> guard(tableLock);
+        unique_ptr<mutex>& lock = locks[entry];
+        if (!lock)
+            lock = make_unique<mutex>();
+        return *lock;
+    }
+
+    // FNV-1a, 64 bit
+    uint64_t hashKey(const string& key)
+    {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : key)
+        {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Unique enough among threads and processes writing the same entry
+    string temporaryName(const string& entry)
+    {
+        static mutex lock;
+        static mt19937_64 rng(random_device{}()
+                              ^ static_cast<uint64_t>(
+                                  chrono::steady_clock::now()
+                                      .time_since_epoch().count()));
+        lock_guard<mutex> guard(lock);
+        ostringstream name;
+        name << entry << ".tmp" << hex << rng();
+        return name.str();
+    }
+}
+
+
+/* ================= FieldCache ================= */
+
+FieldCache::FieldCache(const string& directory)
+    : directory_(directory)
+{
+}
+
+const string& FieldCache::directory() const
+{
+    return directory_;
+}
+
+string FieldCache::path(const string& sourceFile,
+                        const string& timeColumn,
+                        const string& colX,
+                        const string& colY,
+                        const string& colZ,
+                        const DateTime& start,
+                        const DateTime& stop,
+                        double timestep) const
+{
+    if (!fs::exists(sourceFile))
+        throw runtime_error("FieldCache: no such field file: " + sourceFile);
+
+    // The step as simulate() takes it, in ticks
+    int64_t step = (start + timestep).ticks() - start.ticks();
+
+    ostringstream key;
+    key << cacheFormat << '\n'
+        << fs::weakly_canonical(sourceFile).string() << '\n'
+        << fs::file_size(sourceFile) << '\n'
+        << fs::last_write_time(sourceFile).time_since_epoch().count() << '\n'
+        << timeColumn << '\n' << colX << '\n' << colY << '\n' << colZ << '\n'
+        << start.ticks() << '\n' << stop.ticks() << '\n' << step;
+
+    ostringstream name;
+    name << "field-" << hex << hashKey(key.str()) << ".bin";
+    return (fs::path(directory_) / name.str()).string();
+}
+
+bool FieldCache::contains(const string& entry) const
+{
+    return fs::exists(entry);
+}
+
+SampleDataVector FieldCache::field(const string& sourceFile,
+                                   const string& timeColumn,
+                                   const string& colX,
+                                   const string& colY,
+                                   const string& colZ,
+                                   const DateTime& start,
+                                   const DateTime& stop,
+                                   double timestep) const
+{
+    if (!(timestep > 0.0) || !(start < stop))
+        throw invalid_argument("FieldCache: empty run or timestep");
+
+    string entry = path(sourceFile, timeColumn, colX, colY, colZ,
+                        start, stop, timestep);
+    if (!contains(entry)){
+        lock_guard<mutex> guard(buildLock(entry));
+        if (!contains(entry))
+            build(entry, sourceFile, timeColumn, colX, colY, colZ,
+                  start, stop, timestep);
+    }
+    return SampleDataVector::mapBinary(entry);
+}
+
+void FieldCache::build(const string& entry,
+                       const string& sourceFile,
+                       const string& timeColumn,
+                       const string& colX,
+                       const string& colY,
+                       const string& colZ,
+                       const DateTime& start,
+                       const DateTime& stop,
+                       double timestep) const
+{
+    // The run's grid, stepped as simulate() steps it, with a sample
+    // either side so the cubic stencils in between stay centred
+    vector<int64_t> ticks;
+    DateTime t = start + -timestep;
+    for (int past = 0; past < 2; t = t + timestep){
+        ticks.push_back(t.ticks());
+        if (!(t < stop))
+            ++past;
+    }
+
+    SampleDataVector source = SampleDataVector::openWindow(
+        sourceFile, timeColumn, {colX, colY, colZ},
+        DateTime::fromTicks(ticks.front()),
+        DateTime::fromTicks(ticks.back()));
+    if (!source.isWindowed() && !source.isSorted())
+        source.sort();
+
+    size_t count = ticks.size();
+    vector<double> x(count), y(count), z(count);
+    vector<DateTime> times(buildChunk);
+    SampleCursor at;
+    for (size_t base = 0; base < count; base += buildChunk)
+    {
+        size_t m = min(buildChunk, count - base);
+        for (size_t k = 0; k < m; ++k)
+            times[k] = DateTime::fromTicks(ticks[base + k]);
+        source.lagrangeInterpolate(times.data(), m, x.data() + base,
+                                   y.data() + base, z.data() + base, at);
+    }
+
+    fs::create_directories(directory_);
+    int64_t step = count > 1 ? ticks[1] - ticks[0] : 0;
+    UniformGrid grid = series::detectGrid(ticks.data(), count);
+
+    // Written aside and renamed into place, so readers never map a
+    // partial entry; a failed write leaves nothing behind
+    string temporary = temporaryName(entry);
+    try{
+        writeBinarySeries(temporary, count, ticks.data(), x.data(),
+                          y.data(), z.data(), true, grid.valid() ? step : 0);
+        fs::rename(temporary, entry);
+    }
+    catch (...){
+        error_code ignored;
+        fs::remove(temporary, ignored);
+        throw;
+    }
+}
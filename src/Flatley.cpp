@@ -1,8 +1,61 @@
 #include "Flatley.h"
+#include <array>
 #include <cmath>
 using namespace std;
 
 
+namespace
+{
+    // Per interval of [0, 1] the cubic in t = 256 x - i through atan and
+    // its derivative at both ends, as monomial coefficients {c0..c3}
+    const int tableIntervals = 256;
+
+    array<double, 4 * tableIntervals> buildAtanTable()
+    {
+        array<double, 4 * tableIntervals> c{};
+        const double h = 1.0 / tableIntervals;
+        for (int i = 0; i < tableIntervals; ++i)
+        {
+            double x0 = i * h, x1 = (i + 1) * h;
+            double y0 = atan(x0), y1 = atan(x1);
+            double d0 = h / (1.0 + x0 * x0), d1 = h / (1.0 + x1 * x1);
+            double dy = y1 - y0;
+
+            c[4 * i]     = y0;
+            c[4 * i + 1] = d0;
+            c[4 * i + 2] = 3.0 * dy - 2.0 * d0 - d1;
+            c[4 * i + 3] = -2.0 * dy + d0 + d1;
+        }
+        return c;
+    }
+
+    const array<double, 4 * tableIntervals> atanTable = buildAtanTable();
+}
+
+
+double Flatley::tableAtan(double x){
+    double a = fabs(x);
+    bool invert = a > 1.0;
+    if (invert)
+        a = 1.0 / a;
+
+    double s = a * tableIntervals;
+    int i = min(static_cast<int>(s), tableIntervals - 1);
+    double t = s - i;
+    const double* c = atanTable.data() + 4 * i;
+    double r = ((c[3] * t + c[2]) * t + c[1]) * t + c[0];
+
+    if (invert)
+        r = M_PI_2 - r;
+    return copysign(r, x);
+}
+
+
+void Flatley::updateK(){
+    k = tan(pi * bR / (2 * bS)) / hC;
+}
+
+
 void Flatley::updateSlopeSign(){
     // updates the value of slope if slope exceeds some tolerance
     // double BdH = (25*h0 - 48*h1 - 36*h3 + 3*h4)/(12);
@@ -29,18 +82,19 @@ void Flatley::setTolerance(double newTolerance){
 
 void Flatley::setHC(double hCVal){
     hC = hCVal;
+    updateK();
 }
 
 
 void Flatley::setBR(double bRVal){
     bR = bRVal;
-    k = tan(pi * bR / (2 * bS));
+    updateK();
 }
 
 
 void Flatley::setBS(double bSVal){
     bS = bSVal;
-    k = tan(pi * bR / (2 * bS));
+    updateK();
 }
 
 
@@ -61,7 +115,15 @@ void Flatley::setParameters(double hCVal, double bRVal,
     q0 = q0Val;
     p = pVal;
 
-    k = tan(pi * bR / (2 * bS));
+    updateK();
+}
+
+void Flatley::setKernel(Kernel newKernel){
+    kernel = newKernel;
+}
+
+void Flatley::setForm(Form newForm){
+    form = newForm;
 }
 
 
@@ -115,6 +177,35 @@ Vector Flatley::getMagField() const{
     return n0 * b0;
 }
 
+Flatley::Kernel Flatley::getKernel() const{
+    return kernel;
+}
+
+Flatley::Form Flatley::getForm() const{
+    return form;
+}
+
+int Flatley::getSubsteps() const{
+    return substeps;
+}
+
+double Flatley::arctan(double x) const{
+    switch (kernel)
+    {
+    case Kernel::Table:
+        return tableAtan(x);
+    case Kernel::Rational:
+        return rationalAtan(x);
+    default:
+        return atan(x);
+    }
+}
+
+double Flatley::branchField(double h, bool ascending) const{
+    double x = ascending ? k * (h - hC) : k * (h + hC);
+    return (2*bS/pi) * arctan(x);
+}
+
 // Function to get new magnetic field
 double Flatley::calcMagField(double dt, Vector hNew, Vector nNew){
     h4 = h3;
@@ -126,54 +217,24 @@ double Flatley::calcMagField(double dt, Vector hNew, Vector nNew){
 
     updateSlopeSign();
 
-    int numSubsteps = 10;
-
-    double theta = (pi * b0) / (2 * bS);
-    double k0 = tan(theta) / (k * hC);
-    double beta = 0;
-    double alpha = (q0 + (1 - q0) * beta) * (2 * k * bS / pi);
-    double cos2 = pow(cos(theta), 2);
-    double BdH = (h0 - h1)/numSubsteps;
-    double dB = (alpha * cos2 * BdH);
-    double bNew = 0;
-
-    for (int i = 0; i < numSubsteps; i++){
-        /*
-        // double BdH = (25*h0 - 48*h1 - 36*h3 + 3*h4)/(12);
-        theta = (pi * b0) / (2 * bS);
-        k0 = tan(theta) / (k * hC);
-        if (slopeSign == 0)
-            beta = pow((h0 - k0 - hC) / (2 * hC), p);
-        else
-            beta = pow((h0 - k0 + hC) / (2 * hC), p);
-        alpha = (q0 + (1 - q0) * beta) * (2 * k * bS / pi);
-        cos2 = pow(cos(theta), 2);
-        BdH = (h0 - h1)/numSubsteps;
-
-        dB = (alpha * cos2 * BdH / dt);
-
-        bNew = b0 + dB;
-
-        // Limits of magnetic field from inverse tangent model
-        double bMax = (2*bS/pi)*atan(k*(h0 + hC));
-        double bMin = (2*bS/pi)*atan(k*(h0 - hC));
-        if (bNew > bMax){
-            bNew = bMax;
-        } else if(bNew < bMin) {
-            bNew = bMin;
-        }
-        */
-
-        // Inverse tangent model
-        if (slopeSign == 0){
-            bNew = (2*bS/pi)*atan(k*(h0 + hC));
-        } else {
-            bNew = (2*bS/pi)*atan(k*(h0 - hC));
-        };
-
-        bPrev = b0;
-        b0 = bNew;
-    };
+    bPrev = b0;
+    if (form == Form::Differential){
+        // dB/dH integrated from h1 to h0 (see FlatleyDifferential)
+        FlatleyDifferential::Rod rod =
+            FlatleyDifferential::prepare({hC, bR, bS, q0, p});
+        FlatleyDifferential::State state;
+        state.ascending = slopeSign;
+        state.b = b0;
+        b0 = FlatleyDifferential::step(rod, state, h0, h1, tolerance,
+                                       [this](double x){ return arctan(x); });
+        substeps = state.substeps;
+        return b0;
+    }
+
+    // Inverse tangent model: B is the active branch at h0, evaluated
+    // once (it does not depend on the previous B)
+    b0 = branchField(h0, slopeSign);
+    substeps = 0;
 
     return b0;
 }
@@ -0,0 +1,509 @@
+#include "GeomagneticField.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+
+/* ================= Shared helpers ================= */
+
+namespace
+{
+    // IGRF-13, Schmidt semi-normalised, epoch 2020.0 (nT) and secular
+    // variation 2020-25 (nT/year): n, m, g, h, dg, dh
+    struct Coefficient
+    {
+        int n, m;
+        double g, h, dg, dh;
+    };
+
+    const Coefficient igrf13[] = {
+        {1, 0, -29404.8,     0.0,   5.7,   0.0},
+        {1, 1,  -1450.9,  4652.5,   7.4, -25.9},
+        {2, 0,  -2499.6,     0.0, -11.0,   0.0},
+        {2, 1,   2982.0, -2991.6,  -7.0, -30.2},
+        {2, 2,   1677.0,  -734.6,  -2.1, -22.4},
+        {3, 0,   1363.2,     0.0,   2.2,   0.0},
+        {3, 1,  -2381.2,   -82.1,  -5.9,   6.0},
+        {3, 2,   1236.2,   241.9,   3.1,  -1.1},
+        {3, 3,    525.7,  -543.4, -12.0,   0.5},
+        {4, 0,    903.0,     0.0,  -1.2,   0.0},
+        {4, 1,    809.5,   281.9,  -1.6,  -0.1},
+        {4, 2,     86.3,  -158.4,  -5.9,   6.5},
+        {4, 3,   -309.4,   199.7,   5.2,   3.6},
+        {4, 4,     48.0,  -349.7,  -5.1,  -5.0},
+    };
+
+    const int64_t nsPerDay = 86400LL * 1000000000LL;
+    const double nsPerYear = 365.25 * 86400.0 * 1e9;
+
+    // 1 Jan 2000 12:00 UTC (J2000, with UT1 taken as UTC)
+    const int64_t j2000Ticks = 946728000LL * 1000000000LL;
+
+    // Positions evaluated per pass by the batch path (the recursion
+    // scratch, 2 x 120 x 16 doubles, stays in L1)
+    const size_t batchChunk = 16;
+
+    constexpr size_t idx(size_t n, size_t m)
+    {
+        return n * (n + 1) / 2 + m;
+    }
+
+    // Constants of the column recursion
+    //   V_nm = a_nm z0 V_n-1,m - b_nm rho V_n-2,m
+    // for every n, m the field needs, computed once
+    struct Recursion
+    {
+        double a[idx(GeomagneticField::maxDegree + 2, 0)];
+        double b[idx(GeomagneticField::maxDegree + 2, 0)];
+    };
+
+    const Recursion& recursion()
+    {
+        static const Recursion table = []{
+            Recursion r{};
+            for (size_t n = 1; n <= GeomagneticField::maxDegree + 1; ++n)
+                for (size_t m = 0; m < n; ++m)
+                {
+                    double dn = static_cast<double>(n);
+                    double dm = static_cast<double>(m);
+                    r.a[idx(n, m)] = (2.0 * dn - 1.0) / (dn - dm);
+                    r.b[idx(n, m)] = (dn + dm - 1.0) / (dn - dm);
+                }
+            return r;
+        }();
+        return table;
+    }
+
+    int64_t yearStartTicks(int year)
+    {
+        return DateTime("01 Jan " + to_string(year) + " 00:00:00.000")
+            .ticks();
+    }
+}
+
+
+/* ================= GeomagneticField ================= */
+
+GeomagneticField::GeomagneticField()
+{
+    for (const Coefficient& c : igrf13)
+    {
+        size_t i = index(c.n, c.m);
+        g[i] = c.g;
+        h[i] = c.h;
+        dg[i] = c.dg;
+        dh[i] = c.dh;
+        available = max(available, static_cast<size_t>(c.n));
+    }
+    setEpoch(2020);
+    normalise();
+}
+
+GeomagneticField::GeomagneticField(const string& coefficientFile)
+{
+    ifstream file(coefficientFile);
+    if (!file)
+        throw runtime_error("Cannot open coefficient file: "
+                            + coefficientFile);
+
+    bool haveEpoch = false;
+    string line;
+    while (getline(file, line))
+    {
+        istringstream fields(line);
+        vector<string> tokens;
+        for (string token; fields >> token; )
+            tokens.push_back(token);
+        if (tokens.size() < 5 || tokens[0][0] == '#')
+            continue;
+
+        // "g/h n m 1900.0 ... 2020.0 2020-25": the newest model epoch
+        if (tokens[0] == "g/h"){
+            setEpoch(stoi(tokens[tokens.size() - 2]));
+            haveEpoch = true;
+            continue;
+        }
+        if (tokens[0] != "g" && tokens[0] != "h")
+            continue;
+
+        size_t n = stoul(tokens[1]);
+        size_t m = stoul(tokens[2]);
+        if (n == 0 || m > n)
+            throw runtime_error("Bad coefficient in " + coefficientFile
+                                + ": " + line);
+        if (n > maxDegree)
+            continue;
+
+        double value = stod(tokens[tokens.size() - 2]);
+        double rate = stod(tokens[tokens.size() - 1]);
+        size_t i = index(n, m);
+        if (tokens[0] == "g"){
+            g[i] = value;
+            dg[i] = rate;
+        } else {
+            h[i] = value;
+            dh[i] = rate;
+        }
+        available = max(available, n);
+    }
+
+    if (!haveEpoch || available == 0)
+        throw runtime_error("No IGRF coefficients in " + coefficientFile);
+    normalise();
+}
+
+void GeomagneticField::setEpoch(int year)
+{
+    epochTicks = yearStartTicks(year);
+    validUntilTicks = yearStartTicks(year + 5);
+}
+
+void GeomagneticField::normalise()
+{
+    // Schmidt to unnormalised: sqrt(2 (n - m)! / (n + m)!) for m > 0
+    for (size_t n = 1; n <= available; ++n)
+        for (size_t m = 1; m <= n; ++m)
+        {
+            double ratio = 1.0;
+            for (size_t k = n - m + 1; k <= n + m; ++k)
+                ratio /= static_cast<double>(k);
+            double factor = sqrt(2.0 * ratio);
+
+            size_t i = index(n, m);
+            g[i] *= factor;
+            h[i] *= factor;
+            dg[i] *= factor;
+            dh[i] *= factor;
+        }
+    truncation = available;
+}
+
+DateTime GeomagneticField::epoch() const
+{
+    return DateTime::fromTicks(epochTicks);
+}
+
+bool GeomagneticField::covers(const DateTime& t) const
+{
+    return t.ticks() >= epochTicks && t.ticks() < validUntilTicks;
+}
+
+size_t GeomagneticField::degree() const
+{
+    return truncation;
+}
+
+size_t GeomagneticField::availableDegree() const
+{
+    return available;
+}
+
+void GeomagneticField::setDegree(size_t degree)
+{
+    if (degree < 1 || degree > available)
+        throw invalid_argument("GeomagneticField degree out of range");
+    truncation = degree;
+}
+
+double GeomagneticField::earthRotationAngle(const DateTime& t)
+{
+    // ERA = 2 pi (0.7790572732640 + 1.00273781191135448 Du), with the
+    // whole days of Du taken out in integer ticks first
+    int64_t d = t.ticks() - j2000Ticks;
+    int64_t days = d / nsPerDay;
+    int64_t rest = d - days * nsPerDay;
+    if (rest < 0){
+        rest += nsPerDay;
+        --days;
+    }
+    double dayFraction = static_cast<double>(rest)
+                       / static_cast<double>(nsPerDay);
+    double du = static_cast<double>(days) + dayFraction;
+    double turns = 0.7790572732640 + dayFraction
+                 + 0.00273781191135448 * du;
+    return 2.0 * M_PI * (turns - floor(turns));
+}
+
+void GeomagneticField::evaluate(const double* years, const double* x,
+                                const double* y, const double* z,
+                                size_t count, double* bx, double* by,
+                                double* bz) const
+{
+    const Recursion& rec = recursion();
+    const size_t top = truncation + 1;
+    const double a = referenceRadius;
+
+    double V[terms][batchChunk], W[terms][batchChunk];
+    double x0[batchChunk], y0[batchChunk], z0[batchChunk], rho[batchChunk];
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        double r2 = x[k] * x[k] + y[k] * y[k] + z[k] * z[k];
+        x0[k] = a * x[k] / r2;
+        y0[k] = a * y[k] / r2;
+        z0[k] = a * z[k] / r2;
+        rho[k] = a * a / r2;
+        V[0][k] = a / sqrt(r2);
+        W[0][k] = 0.0;
+    }
+
+    /* (a/r)^(n+1) P_nm cos/sin m phi, column by column */
+    for (size_t m = 0; m <= top; ++m)
+    {
+        if (m > 0){
+            const double f = 2.0 * static_cast<double>(m) - 1.0;
+            const double* vp = V[index(m - 1, m - 1)];
+            const double* wp = W[index(m - 1, m - 1)];
+            double* v = V[index(m, m)];
+            double* w = W[index(m, m)];
+            for (size_t k = 0; k < count; ++k)
+            {
+                v[k] = f * (x0[k] * vp[k] - y0[k] * wp[k]);
+                w[k] = f * (x0[k] * wp[k] + y0[k] * vp[k]);
+            }
+        }
+
+        if (m + 1 <= top){
+            const double an = rec.a[index(m + 1, m)];
+            const double* vp = V[index(m, m)];
+            const double* wp = W[index(m, m)];
+            double* v = V[index(m + 1, m)];
+            double* w = W[index(m + 1, m)];
+            for (size_t k = 0; k < count; ++k)
+            {
+                v[k] = an * z0[k] * vp[k];
+                w[k] = an * z0[k] * wp[k];
+            }
+        }
+
+        for (size_t n = m + 2; n <= top; ++n)
+        {
+            const double an = rec.a[index(n, m)];
+            const double bn = rec.b[index(n, m)];
+            const double* v1 = V[index(n - 1, m)];
+            const double* w1 = W[index(n - 1, m)];
+            const double* v2 = V[index(n - 2, m)];
+            const double* w2 = W[index(n - 2, m)];
+            double* v = V[index(n, m)];
+            double* w = W[index(n, m)];
+            for (size_t k = 0; k < count; ++k)
+            {
+                v[k] = an * z0[k] * v1[k] - bn * rho[k] * v2[k];
+                w[k] = an * z0[k] * w1[k] - bn * rho[k] * w2[k];
+            }
+        }
+    }
+
+    /* Gradient of the potential, summed term by term */
+    double gx[batchChunk] = {}, gy[batchChunk] = {}, gz[batchChunk] = {};
+
+    for (size_t n = 1; n <= truncation; ++n)
+    {
+        const double dn = static_cast<double>(n);
+
+        // m = 0 (no h term)
+        {
+            const size_t i = index(n, 0);
+            const double* v0 = V[index(n + 1, 0)];
+            const double* v1 = V[index(n + 1, 1)];
+            const double* w1 = W[index(n + 1, 1)];
+            for (size_t k = 0; k < count; ++k)
+            {
+                double C = g[i] + dg[i] * years[k];
+                gx[k] -= C * v1[k];
+                gy[k] -= C * w1[k];
+                gz[k] -= (dn + 1.0) * C * v0[k];
+            }
+        }
+
+        for (size_t m = 1; m <= n; ++m)
+        {
+            const size_t i = index(n, m);
+            const double dm = static_cast<double>(m);
+            const double f = (dn - dm + 2.0) * (dn - dm + 1.0);
+            const double* vl = V[index(n + 1, m - 1)];
+            const double* wl = W[index(n + 1, m - 1)];
+            const double* vc = V[index(n + 1, m)];
+            const double* wc = W[index(n + 1, m)];
+            const double* vu = V[index(n + 1, m + 1)];
+            const double* wu = W[index(n + 1, m + 1)];
+            for (size_t k = 0; k < count; ++k)
+            {
+                double C = g[i] + dg[i] * years[k];
+                double S = h[i] + dh[i] * years[k];
+                gx[k] += 0.5 * ((-C * vu[k] - S * wu[k])
+                               + f * (C * vl[k] + S * wl[k]));
+                gy[k] += 0.5 * ((-C * wu[k] + S * vu[k])
+                               + f * (-C * wl[k] + S * vl[k]));
+                gz[k] += (dn - dm + 1.0) * (-C * vc[k] - S * wc[k]);
+            }
+        }
+    }
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        bx[k] = -gx[k];
+        by[k] = -gy[k];
+        bz[k] = -gz[k];
+    }
+}
+
+Vector GeomagneticField::fieldECEF(const Vector& position,
+                                   const DateTime& t) const
+{
+    double years = static_cast<double>(t.ticks() - epochTicks) / nsPerYear;
+    double b[3];
+    evaluate(&years, &position[0], &position[1], &position[2], 1,
+             &b[0], &b[1], &b[2]);
+    return Vector{b[0], b[1], b[2]};
+}
+
+Vector GeomagneticField::fieldECI(const Vector& position,
+                                  const DateTime& t) const
+{
+    double b[3];
+    fieldECI(&t, &position[0], &position[1], &position[2], 1,
+             &b[0], &b[1], &b[2]);
+    return Vector{b[0], b[1], b[2]};
+}
+
+void GeomagneticField::fieldECI(const DateTime* times, const double* x,
+                                const double* y, const double* z,
+                                size_t count, double* bx, double* by,
+                                double* bz) const
+{
+    double years[batchChunk], c[batchChunk], s[batchChunk];
+    double xe[batchChunk], ye[batchChunk];
+    double fx[batchChunk], fy[batchChunk];
+
+    for (size_t base = 0; base < count; base += batchChunk)
+    {
+        size_t m = min(batchChunk, count - base);
+
+        // Inertial to Earth-fixed: a rotation by the ERA about z
+        for (size_t k = 0; k < m; ++k)
+        {
+            const DateTime& t = times[base + k];
+            double theta = earthRotationAngle(t);
+            c[k] = cos(theta);
+            s[k] = sin(theta);
+            years[k] = static_cast<double>(t.ticks() - epochTicks)
+                     / nsPerYear;
+            xe[k] =  c[k] * x[base + k] + s[k] * y[base + k];
+            ye[k] = -s[k] * x[base + k] + c[k] * y[base + k];
+        }
+
+        evaluate(years, xe, ye, z + base, m, fx, fy, bz + base);
+
+        for (size_t k = 0; k < m; ++k)
+        {
+            bx[base + k] = c[k] * fx[k] - s[k] * fy[k];
+            by[base + k] = s[k] * fx[k] + c[k] * fy[k];
+        }
+    }
+}
+
+
+/* ================= OrbitField ================= */
+
+OrbitField::OrbitField(const PositionSeries& positions,
+                       const GeomagneticField& model)
+    : positions_(positions), model_(model)
+{
+}
+
+OrbitField::OrbitField(const string& positionFile,
+                       const GeomagneticField& model)
+    : positions_(positionFile, "Time (UTCG)",
+                 {"Position (x)", "Position (y)", "Position (z)"}),
+      model_(model)
+{
+    if (!positions_.isSorted())
+        positions_.sort();
+}
+
+OrbitField::OrbitField(const OrbitPropagator& orbit,
+                       const GeomagneticField& model)
+    : propagator_(orbit), model_(model)
+{
+}
+
+Vector OrbitField::position(const DateTime& t, SampleCursor& at) const
+{
+    if (propagator_)
+        return propagator_->position(t);
+    return positions_.interpolate(t, at);
+}
+
+Vector OrbitField::field(const DateTime& t) const
+{
+    return field(t, cursor);
+}
+
+Vector OrbitField::field(const DateTime& t, SampleCursor& at) const
+{
+    Vector b = model_.fieldECI(position(t, at), t);
+    return b * scale;
+}
+
+void OrbitField::field(const DateTime* times, size_t count,
+                       double* x, double* y, double* z,
+                       SampleCursor& at) const
+{
+    double px[batchChunk], py[batchChunk], pz[batchChunk];
+
+    for (size_t base = 0; base < count; base += batchChunk)
+    {
+        size_t m = min(batchChunk, count - base);
+        for (size_t k = 0; k < m; ++k)
+        {
+            Vector p = position(times[base + k], at);
+            px[k] = p[0];
+            py[k] = p[1];
+            pz[k] = p[2];
+        }
+
+        model_.fieldECI(times + base, px, py, pz, m,
+                        x + base, y + base, z + base);
+        for (size_t k = 0; k < m; ++k)
+        {
+            x[base + k] *= scale;
+            y[base + k] *= scale;
+            z[base + k] *= scale;
+        }
+    }
+}
+
+bool OrbitField::isPropagated() const
+{
+    return propagator_.has_value();
+}
+
+const OrbitField::PositionSeries& OrbitField::positions() const
+{
+    return positions_;
+}
+
+const OrbitPropagator& OrbitField::propagator() const
+{
+    if (!propagator_)
+        throw logic_error("OrbitField: positions are not propagated");
+    return *propagator_;
+}
+
+const GeomagneticField& OrbitField::model() const
+{
+    return model_;
+}
+
+OrbitField OrbitField::operator*(double scalar) const
+{
+    OrbitField result = *this;
+    result.scale *= scalar;
+    return result;
+}
@@ -0,0 +1,11 @@
+#include "HysteresisRodBank.h"
+#include "HysteresisRodBank.tpp"
+
+
+/* ================= Instantiations ================= */
+
+// The models of HysteresisModel.h, compiled here (with the flags the
+// update pass needs to vectorise, see CMakeLists.txt)
+template class BasicHysteresisRodBank<FlatleyAtan>;
+template class BasicHysteresisRodBank<FlatleyDifferential>;
+template class BasicHysteresisRodBank<JilesAtherton>;
@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string& filename)
+    : filename(filename)
+{
+    ifstream file(filename, ios::binary | ios::ate);
+    if (!file)
+        throw runtime_error("Cannot open file: " + filename);
+
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(buffer.data(), buffer.size());
+
+    begin = buffer.data();
+    length = buffer.size();
+}
+
+MappedFile::~MappedFile()
+{}
+
+void MappedFile::release(size_t, size_t) const
+{}
+
+#else
+
+MappedFile::MappedFile(const string& filename)
+    : filename(filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw runtime_error("Cannot open file: " + filename);
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0){
+        ::close(fd);
+        throw runtime_error("Cannot stat file: " + filename);
+    }
+    length = static_cast<size_t>(info.st_size);
+
+    if (length > 0){
+        void* ptr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED){
+            ::close(fd);
+            throw runtime_error("Cannot map file: " + filename);
+        }
+        begin = static_cast<const char*>(ptr);
+    }
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (begin)
+        ::munmap(const_cast<char*>(begin), length);
+}
+
+void MappedFile::release(size_t offset, size_t bytes) const
+{
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+
+    size_t first = (offset + page - 1) / page * page;
+    size_t last = std::min(offset + bytes, length) / page * page;
+    if (begin && first < last)
+        ::madvise(const_cast<char*>(begin) + first, last - first,
+                  MADV_DONTNEED);
+}
+
+#endif
+
+const char* MappedFile::data() const
+{
+    return begin;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
+
+const string& MappedFile::name() const
+{
+    return filename;
+}
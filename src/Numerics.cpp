@@ -1,501 +1,301 @@
 #include "Numerics.h"
 #include "DateTime.h"
+#include "CsvReader.h"
 #include <algorithm>
-#include <fstream>
-#include <sstream>
 #include <stdexcept>
 #include <iostream>
 
 
-/* ================= SamplePoint1D ================= */
+/* ================= Shared helpers ================= */
 
-SamplePoint1D::SamplePoint1D(const DateTime& time,
-                             double val)
-    : t(time), y(val)
+namespace
 {
-}
-
-bool SamplePoint1D::operator<(const SamplePoint1D& other) const
-{
-    return t < other.t;
-}
-
-
-/* ================= SampleData1D ================= */
-
-SampleData1D::SampleData1D()
-    : position(0), sorted_(true)
-{
-}
-
-SampleData1D::SampleData1D(const string& filename,
-                           const string& timeColumn,
-                           const string& valueColumn)
-    : position(0), sorted_(true)
-{
-    std::ifstream file(filename);
-    if (!file)
-        throw std::runtime_error("Cannot open CSV file");
-
-    string line;
-    vector<string> header;
-
-    std::getline(file, line);
-    std::stringstream hs(line);
-
-    string token;
-    while (std::getline(hs, token, ','))
-        header.push_back(token);
-
-    size_t tIdx = findColumn(header, timeColumn);
-    size_t vIdx = findColumn(header, valueColumn);
-
-    while (std::getline(file, line))
+    using series::detectGrid;
+    using series::ticksSorted;
+
+    // Monomial coefficients of the 4-point Lagrange cubic of every
+    // interval (see FieldStorage::buildInterpolant), laid out as
+    // SeriesView::coeff
+    void buildCoefficients(const SeriesView<3>& v,
+                           vector<double>& interpolant,
+                           vector<double>& invSpan)
     {
-        std::stringstream ss(line);
-        vector<string> values;
-
-        while (std::getline(ss, token, ','))
-            values.push_back(token);
+        size_t n = v.count;
+        const int64_t* t = v.t;
+        if (n <= 4)
+            throw std::runtime_error("Less than four data values provided");
 
-        DateTime t(values[tIdx]);
-        double y = std::stod(values[vIdx]);
+        size_t intervals = n - 1;
+        interpolant.resize(12 * intervals);
+        invSpan.resize(intervals);
 
-        data.emplace_back(t, y);
+        for (size_t i = 0; i < intervals; ++i)
+        {
+            // Same stencil as the direct path of lagrangeInterpolate()
+            size_t s0 = Lagrange<4>::first(i, n);
+
+            if (t[i + 1] == t[i])
+                throw std::runtime_error(
+                    "SampleDataVector has duplicate time stamps"
+                );
+            double inv = 1.0 / static_cast<double>(t[i + 1] - t[i]);
+
+            // Stencil nodes in interval units (about -1, 0, 1, 2)
+            double node[4];
+            for (int k = 0; k < 4; ++k)
+                node[k] = static_cast<double>(t[s0 + k] - t[i]) * inv;
+
+            // Monomial coefficients of each Lagrange basis polynomial
+            //   (u - a)(u - b)(u - c) / ((n_k - a)(n_k - b)(n_k - c))
+            double basis[4][4];
+            for (int k = 0; k < 4; ++k)
+            {
+                double r[3];
+                for (int j = 0, m = 0; j < 4; ++j)
+                    if (j != k)
+                        r[m++] = node[j];
+
+                double denom = (node[k] - r[0]) * (node[k] - r[1])
+                             * (node[k] - r[2]);
+                basis[k][0] = -r[0] * r[1] * r[2] / denom;
+                basis[k][1] = (r[0] * r[1] + r[1] * r[2] + r[2] * r[0])
+                            / denom;
+                basis[k][2] = -(r[0] + r[1] + r[2]) / denom;
+                basis[k][3] = 1.0 / denom;
+            }
+
+            double* out = &interpolant[12 * i];
+            for (int d = 0; d < 3; ++d)
+            {
+                const double* col = v.columns[d];
+                for (int p = 0; p < 4; ++p)
+                    out[4 * d + p] = col[s0]     * basis[0][p]
+                                   + col[s0 + 1] * basis[1][p]
+                                   + col[s0 + 2] * basis[2][p]
+                                   + col[s0 + 3] * basis[3][p];
+            }
+            invSpan[i] = inv;
+        }
     }
 
-    sorted_ = checkSort();
+    // Samples carried over when the window slides, enough for the
+    // stencil of the interval that straddles the seam
+    const size_t windowOverlap = 3;
 }
 
-size_t SampleData1D::findColumn(const vector<string>& header,
-                                const string& name) const
-{
-    for (size_t i = 0; i < header.size(); ++i)
-        if (header[i] == name)
-            return i;
 
-    throw std::runtime_error("Column not found: " + name);
-}
+/* ================= FieldStorage ================= */
 
-void SampleData1D::addSample(const DateTime& t,
-                             double y)
+struct FieldStorage::Window
 {
-    data.emplace_back(t, y);
-    sorted_ = false;
-}
+    std::unique_ptr<CsvStream> stream;
+    bool exhausted = false;
 
-void SampleData1D::sort()
-{
-    std::sort(data.begin(), data.end());
-    sorted_ = true;
-    position = 0;
-}
+    SeriesSamples<3> samples;
 
-bool SampleData1D::checkSort() const
-{
-    for (size_t i = 1; i < data.size(); ++i)
-    {
-        if (data[i] < data[i - 1])
-            return false;
-    }
-    return true;
-}
+    bool wantInterpolant = false;
+    vector<double> interpolant;
+    vector<double> invSpan;
+};
 
-bool SampleData1D::isSorted() const
+FieldStorage::FieldStorage()
+    : owned(std::make_shared<Owned>())
 {
-    return sorted_;
 }
 
-void SampleData1D::requireSorted() const
+FieldStorage FieldStorage::mapBinary(const string& filename)
 {
-    if (!sorted_)
-        throw std::runtime_error("SampleData1D not sorted");
+    FieldStorage result;
+    result.mapped = std::make_shared<const MappedFile>(filename);
+    result.binary = viewBinarySeries(*result.mapped);
+
+    // The writer records the grid, so the ticks need not be scanned
+    if (result.binary.gridStep > 0 && result.binary.count > 0)
+        result.owned->samples.grid = UniformGrid{result.binary.ticks[0],
+                                                 result.binary.gridStep};
+    return result;
 }
 
-void SampleData1D::setPosition(const DateTime time) const{
-
-    if (data.empty()){
-        throw std::runtime_error("SampleDataVector Empty");
-    }
-
-    /* Move forward if t is ahead */
-    while (position + 1 < data.size() &&
-           !(time < data[position + 1].t)){
-        ++position;
-    }
-
-    /* Move backward if t is behind */
-    while (position > 0 &&
-           time < data[position].t){
-        --position;
-    }
-
-    // making sure the skeleton does not go out of the range of values
-    if (data.size() <= 4){
-        throw std::runtime_error("Less than four data values provided");
-    } else if (position < 1){
-        position = 1;
-    } else if (position + 3 >= data.size()){
-        position = data.size() - 3;
-    }
+FieldStorage FieldStorage::openWindow(const string& filename,
+                                      const string& timeColumn,
+                                      const vector<string>& valueColumns,
+                                      const DateTime& start,
+                                      const DateTime& stop,
+                                      size_t blockRows)
+{
+    if (isBinarySeries(filename))
+        return mapBinary(filename);
+
+    FieldStorage result;
+    result.window = std::make_shared<Window>();
+    result.window->stream = std::make_unique<CsvStream>(
+        filename, timeColumn, valueColumns, start.ticks(), stop.ticks(),
+        blockRows, windowOverlap
+    );
+
+    // Priming the window so that the first query does not wait
+    SampleCursor at;
+    result.advance(start.ticks(), at);
+    return result;
 }
 
-double SampleData1D::linearInterpolate(const DateTime& t) const
+void FieldStorage::writeBinary(const string& filename, bool sorted) const
 {
-    requireSorted();
+    if (window)
+        throw std::runtime_error("Cannot write a windowed SampleDataVector");
 
-    if (data.empty()) {
-    throw std::runtime_error(
-            "Interpolation requested on empty SampleDataVector"
-        );
-    }
-
-    /* Move forward if t is ahead */
-    while (position + 1 < data.size() &&
-           !(t < data[position + 1].t)){
-        ++position;
-    }
+    SeriesView<3> v = view();
 
-    /* Move backward if t is behind */
-    while (position > 0 &&
-           t < data[position].t){
-        --position;
+    if (factor == 1.0){
+        writeBinarySeries(filename, v.count, v.t, v.columns[0],
+                          v.columns[1], v.columns[2], sorted, v.grid.step);
+        return;
     }
 
-    // Checking if position has exceeded data size
-    if (position >= data.size()) {
-        position = data.size() - 1;
+    // A scaled series is written out with the scale applied
+    std::array<vector<double>, 3> scaled;
+    for (size_t d = 0; d < 3; ++d)
+    {
+        scaled[d].assign(v.columns[d], v.columns[d] + v.count);
+        for (double& value : scaled[d])
+            value *= factor;
     }
-
-
-    const auto& p0 = data[position];
-    const auto& p1 = data[position + 1];
-
-    double dt = t - p0.t;
-    double dtTot = p1.t - p0.t;
-
-    return p0.y +
-           (p1.y - p0.y) * (dt / dtTot);
+    writeBinarySeries(filename, v.count, v.t, scaled[0].data(),
+                      scaled[1].data(), scaled[2].data(), sorted,
+                      v.grid.step);
 }
 
-double SampleData1D::lagrangeInterpolate(const DateTime& t) const
+void FieldStorage::buildInterpolant()
 {
-    requireSorted();
-    setPosition(t);
-
-    size_t i0 = (position > 0) ? position - 1 : position;
-    size_t i1 = position;
-    size_t i2 = position + 1;
-    size_t i3 = (position + 2 < data.size())
-                ? position + 2
-                : position + 1;
-
-    const SamplePoint1D* p[4] =
-        { &data[i0], &data[i1], &data[i2], &data[i3] };
-
-    double result = 0.0;
-
-    for (int i = 0; i < 4; ++i)
-    {
-        double term = p[i]->y;
-
-        for (int j = 0; j < 4; ++j)
-        {
-            if (i != j)
-                term *= (t - p[j]->t) /
-                        (p[i]->t - p[j]->t);
-        }
-        result += term;
+    if (window){
+        Window& w = *window;
+        w.wantInterpolant = true;
+        buildCoefficients(view(), w.interpolant, w.invSpan);
+        return;
     }
 
-    return result;
+    // Owned values take the scale on first (mapped ones keep it on
+    // access), and the result goes in unshared storage
+    if (!mapped)
+        own();
+    else if (owned.use_count() > 1)
+        owned = std::make_shared<Owned>(*owned);
+    buildCoefficients(view(), owned->interpolant, owned->invSpan);
 }
 
-size_t SampleData1D::size() const
+SeriesView<3> FieldStorage::windowView() const
 {
-    return data.size();
+    const Window& w = *window;
+    SeriesView<3> v;
+    v.count = w.samples.ticks.size();
+    v.t = w.samples.ticks.data();
+    for (size_t d = 0; d < 3; ++d)
+        v.columns[d] = w.samples.columns[d].data();
+    v.grid = w.samples.grid;
+    v.scale = factor;
+    if (!w.interpolant.empty()){
+        v.coeff = w.interpolant.data();
+        v.invSpan = w.invSpan.data();
+    }
+    return v;
 }
 
-SampleData1D SampleData1D::operator*(double scalar) const
+SeriesSamples<3>& FieldStorage::own()
 {
-    SampleData1D result;
-
-    result.data.reserve(data.size());
-
-    for (const auto& p : data)
-    {
-        result.data.emplace_back(p.t, p.y * scalar);
+    if (mapped)
+        throw std::runtime_error("Cannot modify a mapped SampleDataVector");
+    if (window)
+        throw std::runtime_error("Cannot modify a windowed SampleDataVector");
+
+    if (owned.use_count() > 1)
+        owned = std::make_shared<Owned>(*owned);
+
+    if (factor != 1.0){
+        Owned& o = *owned;
+        for (vector<double>& column : o.samples.columns)
+            for (double& v : column)
+                v *= factor;
+        for (double& v : o.interpolant)
+            v *= factor;
+        factor = 1.0;
     }
-
-    result.sorted_ = sorted_;
-    result.position = position;
-
-    return result;
+    return owned->samples;
 }
 
-
-/* ================= SamplePointVector ================= */
-
-SamplePointVector::SamplePointVector(const DateTime& time,
-                                     const Vector& val)
-    : t(time), y(val)
+bool FieldStorage::isSorted() const
 {
+    return mapped ? binary.sorted : true;
 }
 
-bool SamplePointVector::operator<(const SamplePointVector& other) const
+bool FieldStorage::isMapped() const
 {
-    return t < other.t;
+    return mapped != nullptr;
 }
 
-
-/* ================= SampleDataVector ================= */
-
-SampleDataVector::SampleDataVector()
-    : position(0), sorted_(true)
+bool FieldStorage::isWindowed() const
 {
+    return window != nullptr;
 }
 
-SampleDataVector::SampleDataVector(const string& filename,
-                                   const string& timeColumn,
-                                   const string& colX,
-                                   const string& colY,
-                                   const string& colZ)
-    : position(0), sorted_(true)
+void FieldStorage::slide(int64_t time, SampleCursor& at) const
 {
-    std::ifstream file(filename);
-    if (!file)
-        throw std::runtime_error("Cannot open CSV file");
+    Window& w = *window;
+    SeriesSamples<3>& s = w.samples;
+    bool slid = false;
 
-    string line;
-    vector<string> header;
-
-    std::getline(file, line);
-    std::stringstream hs(line);
-
-    string token;
-    while (std::getline(hs, token, ','))
-        header.push_back(token);
-
-    size_t tIdx = findColumn(header, timeColumn);
-    size_t xIdx = findColumn(header, colX);
-    size_t yIdx = findColumn(header, colY);
-    size_t zIdx = findColumn(header, colZ);
-
-
-    while (std::getline(file, line))
+    // Sliding until the stencil of time's interval is inside the window
+    while (!w.exhausted
+           && (s.ticks.size() < 4 || !(time < s.ticks[s.ticks.size() - 2])))
     {
-        if (line.empty())
-            continue;
-
-        std::stringstream ss(line);
-        vector<string> values;
-        string token;
-
-        while (std::getline(ss, token, ','))
-            values.push_back(token);
-
-        /* Check column bounds */
-        if (tIdx >= values.size() ||
-            xIdx >= values.size() ||
-            yIdx >= values.size() ||
-            zIdx >= values.size()
-            ){
-            std::cerr << "Skipping malformed line (column missing)\n";
-            continue;
+        CsvSeries block;
+        if (!w.stream->next(block)){
+            w.exhausted = true;
+            break;
         }
 
-        /* Construct DateTime safely */
-        DateTime t;
-        try{
-            t = DateTime(values[tIdx]);
-        }
-        catch (...){
-            std::cerr << "Invalid DateTime: "
-                      << values[tIdx] << '\n';
-            continue;
-        }
+        size_t n = s.ticks.size();
+        size_t dropped = n - std::min(n, windowOverlap);
 
-        /* Convert vector components safely */
-        double vx, vy, vz;
+        if (!ticksSorted(block.ticks.data(), block.ticks.size())
+            || (n > 0 && !block.ticks.empty()
+                && block.ticks.front() < s.ticks.back()))
+            throw std::runtime_error("Windowed SampleDataVector not sorted");
 
-        try{
-            vx = std::stod(values[xIdx]);
-            vy = std::stod(values[yIdx]);
-            vz = std::stod(values[zIdx]);
-        }
-        catch (...){
-            std::cerr << "Invalid numeric data at time "
-                      << t.display() << '\n';
-            continue;
+        s.ticks.erase(s.ticks.begin(), s.ticks.begin() + dropped);
+        s.ticks.insert(s.ticks.end(), block.ticks.begin(), block.ticks.end());
+
+        for (size_t d = 0; d < 3; ++d)
+        {
+            vector<double>& col = s.columns[d];
+            col.erase(col.begin(), col.begin() + dropped);
+            for (size_t i = 0; i < block.rows(); ++i)
+                col.push_back(block.values[3 * i + d]);
         }
 
-        /* Diagnostic print BEFORE storing 
-        For Debug only
-        std::cout << "Time   : " << t.display() << '\n'
-                  << "Vector : "
-                  << vx << ", "
-                  << vy << ", "
-                  << vz << "\n\n";
-        */
-
-        Vector v = { vx, vy, vz };
-        data.emplace_back(t, v);
+        at.position = at.position > dropped ? at.position - dropped : 0;
+        slid = true;
     }
-    sorted_ = checkSort();
-}
-
-size_t SampleDataVector::findColumn(const vector<string>& header,
-                                    const string& name) const
-{
-    for (size_t i = 0; i < header.size(); ++i)
-        if (header[i] == name)
-            return i;
-
-    throw std::runtime_error("Column not found: " + name);
-}
-
-void SampleDataVector::addSample(const DateTime& t,
-                                 const Vector& y)
-{
-    data.emplace_back(t, y);
-    sorted_ = false;
-}
 
-void SampleDataVector::sort()
-{
-    std::sort(data.begin(), data.end());
-    sorted_ = true;
-    position = 0;
-}
-
-bool SampleDataVector::checkSort() const
-{
-    for (size_t i = 1; i < data.size(); ++i)
-    {
-        if (data[i] < data[i - 1])
-            return false;
+    if (slid){
+        s.grid = detectGrid(s.ticks.data(), s.ticks.size());
+        if (w.wantInterpolant && s.ticks.size() > 4)
+            buildCoefficients(view(), w.interpolant, w.invSpan);
     }
-    return true;
 }
 
-bool SampleDataVector::isSorted() const
+void FieldStorage::invalidate()
 {
-    return sorted_;
+    owned->interpolant.clear();
+    owned->invSpan.clear();
 }
 
-void SampleDataVector::requireSorted() const
+void FieldStorage::rebuild()
 {
-    if (!sorted_)
-        throw std::runtime_error("SampleDataVector not sorted");
+    if (!owned->interpolant.empty())
+        buildInterpolant();
 }
 
-void SampleDataVector::setPosition(const DateTime time) const{
-
-    if (data.empty()){
-        throw std::runtime_error("SampleDataVector Empty");
-    }
-
-    /* Move forward if t is ahead */
-    while (position + 1 < data.size() &&
-           !(time < data[position + 1].t)){
-        ++position;
-    }
-
-    /* Move backward if t is behind */
-    while (position > 0 &&
-           time < data[position].t){
-        --position;
-    }
-
-    // making sure the skeleton does not go out of the range of values
-    if (data.size() <= 4){
-        throw std::runtime_error("Less than four data values provided");
-    } else if (position < 1){
-        position = 1;
-    } else if (position + 3 >= data.size()){
-        position = data.size() - 3;
-    }
-}
-
-
-Vector SampleDataVector::linearInterpolate(const DateTime& t) const{
-    requireSorted();
-
-    setPosition(t);
-
-    const auto& p0 = data[position];
-    const auto& p1 = data[position + 1];
-
-    double dt = t - p0.t;
-    double dtTot = p1.t - p0.t;
-
-    return p0.y +
-           (p1.y - p0.y) * (dt / dtTot);
-}
-
-Vector SampleDataVector::lagrangeInterpolate(const DateTime& t) const{
-    requireSorted();
-
-    /* Move forward if t is ahead */
-    while (position + 1 < data.size() &&
-           !(t < data[position + 1].t)){
-        ++position;
-    }
-
-    /* Move backward if t is behind */
-    while (position > 0 &&
-           t < data[position].t){
-        --position;
-    }
-
-    // Checking if position has exceeded data size
-    if (position >= data.size()) {
-        position = data.size() - 1;
-    }
-
-    size_t i0 = (position > 0) ? position - 1 : position;
-    size_t i1 = position;
-    size_t i2 = position + 1;
-    size_t i3 = (position + 2 < data.size())
-                ? position + 2
-                : position + 1;
-
-    const SamplePointVector* p[4] =
-        { &data[i0], &data[i1], &data[i2], &data[i3] };
-
-    Vector result = {0, 0, 0};
-
-    for (int i = 0; i < 4; ++i){
-        double coeff = 1.0;
-
-        for (int j = 0; j < 4; ++j){
-            if (i != j)
-                coeff *= (t - p[j]->t) / (p[i]->t - p[j]->t);
-        }
-        result = result + p[i]->y * coeff;
-    }
-
-    return result;
-}
-
-size_t SampleDataVector::size() const
-{
-    return data.size();
-}
-
-SampleDataVector SampleDataVector::operator*(double scalar) const
+void FieldStorage::scale(double scalar)
 {
-    SampleDataVector result;
-
-    result.data.reserve(data.size());
-
-    for (const auto& p : data)
-    {
-        result.data.emplace_back(p.t, p.y * scalar);
-    }
-
-    result.sorted_ = sorted_;
-    result.position = position;
-
-    return result;
+    factor *= scalar;
 }
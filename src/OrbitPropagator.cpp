@@ -0,0 +1,215 @@
+#include "OrbitPropagator.h"
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+
+/* ================= Shared helpers ================= */
+
+namespace
+{
+    // Eccentric anomaly for mean anomaly M (Newton, from M + e sin M)
+    double eccentricAnomaly(double M, double e)
+    {
+        double E = M + e * sin(M);
+        for (int i = 0; i < 20; ++i)
+        {
+            double step = (E - e * sin(E) - M) / (1.0 - e * cos(E));
+            E -= step;
+            if (fabs(step) < 1e-14)
+                break;
+        }
+        return E;
+    }
+}
+
+
+/* ================= OrbitPropagator ================= */
+
+OrbitPropagator::OrbitPropagator(const OrbitElements& elements, Model model)
+    : elements_(elements), model_(model)
+{
+    const OrbitElements& el = elements_;
+    if (!(el.semiMajorAxis > 0.0) || el.eccentricity < 0.0
+        || !(el.eccentricity < 1.0))
+        throw invalid_argument("OrbitPropagator: not an elliptic orbit");
+
+    double n = sqrt(mu / (el.semiMajorAxis * el.semiMajorAxis
+                          * el.semiMajorAxis));
+    meanAnomalyDot = n;
+
+    if (model_ == Model::J2)
+    {
+        double e2 = el.eccentricity * el.eccentricity;
+        double p = el.semiMajorAxis * (1.0 - e2);
+        double k = j2 * (earthRadius / p) * (earthRadius / p) * n;
+        double c = cos(el.inclination);
+
+        raanDot = -1.5 * k * c;
+        argPerigeeDot = 0.75 * k * (5.0 * c * c - 1.0);
+        meanAnomalyDot += 0.75 * k * sqrt(1.0 - e2) * (3.0 * c * c - 1.0);
+    }
+}
+
+OrbitPropagator OrbitPropagator::circular(double altitude,
+                                          double inclination,
+                                          const DateTime& epoch,
+                                          double raan,
+                                          double argLatitude,
+                                          Model model)
+{
+    OrbitElements el;
+    el.semiMajorAxis = earthRadius + altitude;
+    el.inclination = inclination;
+    el.raan = raan;
+    el.meanAnomaly = argLatitude;
+    el.epoch = epoch;
+    return OrbitPropagator(el, model);
+}
+
+OrbitPropagator OrbitPropagator::fromState(const Vector& position,
+                                           const Vector& velocity,
+                                           const DateTime& epoch,
+                                           Model model)
+{
+    const Vector& r = position;
+    const Vector& v = velocity;
+    double rm = r.magnitude();
+    double v2 = v * v;
+    double rv = r * v;
+    Vector hv = r ^ v;
+    double h = hv.magnitude();
+
+    OrbitElements el;
+    el.epoch = epoch;
+    el.semiMajorAxis = 1.0 / (2.0 / rm - v2 / mu);
+    el.inclination = acos(hv[2] / h);
+
+    // Node and argument of latitude (in the equator for i = 0)
+    double u;
+    if (sin(el.inclination) > 1e-12){
+        el.raan = atan2(hv[0], -hv[1]);
+        double cO = cos(el.raan), sO = sin(el.raan);
+        u = atan2(r[2] / sin(el.inclination), r[0] * cO + r[1] * sO);
+    } else {
+        el.raan = 0.0;
+        u = atan2(r[1], r[0]);
+    }
+
+    // True anomaly from e cos nu = p / r - 1 and e sin nu = r.v h / mu r,
+    // well defined for near circular orbits (then it is all in u)
+    double ec = h * h / (mu * rm) - 1.0;
+    double es = rv * h / (mu * rm);
+    el.eccentricity = sqrt(ec * ec + es * es);
+    double nu = atan2(es, ec);
+    el.argPerigee = u - nu;
+
+    double e = el.eccentricity;
+    double E = 2.0 * atan2(sqrt(1.0 - e) * sin(0.5 * nu),
+                           sqrt(1.0 + e) * cos(0.5 * nu));
+    el.meanAnomaly = E - e * sin(E);
+
+    // Kozai's first order short periodic part of a, removed to get the
+    // mean semi-major axis that sets the mean motion
+    if (model == Model::J2)
+    {
+        double a = el.semiMajorAxis;
+        double s2 = sin(el.inclination) * sin(el.inclination);
+        double ar3 = (a / rm) * (a / rm) * (a / rm);
+        double da = j2 * earthRadius * earthRadius / a
+                  * ((1.0 - 1.5 * s2) * (ar3 - pow(1.0 - e * e, -1.5))
+                     + 1.5 * s2 * ar3 * cos(2.0 * u));
+        el.semiMajorAxis = a - da;
+    }
+
+    return OrbitPropagator(el, model);
+}
+
+void OrbitPropagator::state(const DateTime& t,
+                            Vector& position, Vector& velocity) const
+{
+    const OrbitElements& el = elements_;
+    double dt = t - el.epoch;
+
+    double M = el.meanAnomaly + meanAnomalyDot * dt;
+    double O = el.raan + raanDot * dt;
+    double w = el.argPerigee + argPerigeeDot * dt;
+    double e = el.eccentricity;
+    double a = el.semiMajorAxis;
+    double b = a * sqrt(1.0 - e * e);
+
+    double E = eccentricAnomaly(remainder(M, 2.0 * M_PI), e);
+    double cE = cos(E), sE = sin(E);
+    double Edot = meanAnomalyDot / (1.0 - e * cE);
+
+    // In the orbit plane (x to perigee); the turning perigee adds to
+    // the velocity
+    double x = a * (cE - e), y = b * sE;
+    double vx = -a * sE * Edot - argPerigeeDot * y;
+    double vy = b * cE * Edot + argPerigeeDot * x;
+
+    double cO = cos(O), sO = sin(O);
+    double cw = cos(w), sw = sin(w);
+    double ci = cos(el.inclination), si = sin(el.inclination);
+    Vector P{cO * cw - sO * sw * ci, sO * cw + cO * sw * ci, sw * si};
+    Vector Q{-cO * sw - sO * cw * ci, -sO * sw + cO * cw * ci, cw * si};
+
+    position = P * x + Q * y;
+    velocity = P * vx + Q * vy
+             + Vector{-position[1], position[0], 0.0} * raanDot;
+}
+
+Vector OrbitPropagator::position(const DateTime& t) const
+{
+    Vector r, v;
+    state(t, r, v);
+    return r;
+}
+
+Vector OrbitPropagator::velocity(const DateTime& t) const
+{
+    Vector r, v;
+    state(t, r, v);
+    return v;
+}
+
+Vector OrbitPropagator::interpolate(const DateTime& t) const
+{
+    return position(t);
+}
+
+Vector OrbitPropagator::interpolate(const DateTime& t, SampleCursor&) const
+{
+    return position(t);
+}
+
+const OrbitElements& OrbitPropagator::elements() const
+{
+    return elements_;
+}
+
+OrbitPropagator::Model OrbitPropagator::model() const
+{
+    return model_;
+}
+
+double OrbitPropagator::period() const
+{
+    return 2.0 * M_PI / meanAnomalyDot;
+}
+
+double OrbitPropagator::raanRate() const
+{
+    return raanDot;
+}
+
+double OrbitPropagator::argPerigeeRate() const
+{
+    return argPerigeeDot;
+}
+
+double OrbitPropagator::meanAnomalyRate() const
+{
+    return meanAnomalyDot;
+}
@@ -0,0 +1,17 @@
+#include "Quaternion.h"
+#include <sstream>
+#include <iomanip>
+using namespace std;
+
+// NOTE: All arithmetic is defined inline in Quaternion.h.
+
+string Quaternion::display() const
+{
+    ostringstream oss;
+    oss << fixed << setprecision(4);
+    oss << "[" << setw(9) << w
+        << setw(9) << x
+        << setw(9) << y
+        << setw(9) << z << "]";
+    return oss.str();
+}
@@ -4,6 +4,7 @@
 #include "Vector.h"
 #include <sstream>
 #include <cmath>
+#include "Debug.h"
 using namespace std;
 
 
@@ -13,42 +14,41 @@ using namespace std;
 
 
 // Default constructor
-Satellite::Satellite()
+template <typename Model>
+BasicSatellite<Model>::BasicSatellite()
     : momentOfInertia({
         1, 0, 0,
         0, 1, 0,
         0, 0, 1
       }),
-      x({1,0,0}),
-      y({0,1,0}),
-      z({0,0,1}),
+      attitude(),
       angularVelocity({1, 0, 0}),
       angularAcceleration({1, 0, 0})
-{}
+{
+    updateInertiaCache();
+
+    // The model's default loop
+    addAxisRods(Loop{});
+}
 
 
 // Parameterized constructor
-Satellite::Satellite(Matrix inMOI,
-                     Vector inX,
-                     Vector inY,
-                     Vector inZ,
-                     Vector inOmega,
-                     Vector inAlpha,
-                     double inBarM,
-                     double inHystVol,
-                     double inHystNd,
-                     int inNumXHyst,
-                     int inNumYHyst,
-                     int inNumZHyst,
-                     double hC,
-                     double bR,
-                     double bS,
-                     double q0,
-                     double p)
+template <typename Model>
+BasicSatellite<Model>::BasicSatellite(Matrix inMOI,
+                                      Vector inX,
+                                      Vector inY,
+                                      Vector inZ,
+                                      Vector inOmega,
+                                      Vector inAlpha,
+                                      double inBarM,
+                                      double inHystVol,
+                                      double inHystNd,
+                                      int inNumXHyst,
+                                      int inNumYHyst,
+                                      int inNumZHyst,
+                                      const Loop& loop)
     : momentOfInertia(inMOI),
-      x(inX),
-      y(inY),
-      z(inZ),
+      attitude(Quaternion::fromAxes(inX, inY, inZ)),
       angularVelocity(inOmega),
       angularAcceleration(inAlpha),
       barM(inBarM),
@@ -58,30 +58,11 @@ Satellite::Satellite(Matrix inMOI,
       numYHyst(inNumYHyst),
       numZHyst(inNumZHyst)
 {
-    // hystMX, hystMY, hystMZ remain 0.0
-    double h0Init = 0;
-    double h1Init = 0;
-    double h2Init = 0;
-    double h3Init = 0;
-    double h4Init = 0;
-    Vector n0InitX = x;
-    Vector n0InitY = x;
-    Vector n0InitZ = x;
-
-    hystX = Flatley(h0Init, h1Init, h2Init, h3Init, h4Init, 
-                    n0InitX,
-                    hC, bR, bS, q0, p);
-    hystY = Flatley(h0Init, h1Init, h2Init, h3Init, h4Init, 
-                    n0InitY,
-                    hC, bR, bS, q0, p);
-    hystZ = Flatley(h0Init, h1Init, h2Init, h3Init, h4Init, 
-                    n0InitZ,
-                    hC, bR, bS, q0, p);
-    Matrix R = {
-        x[0], y[0], z[0],
-        x[1], y[1], z[1],
-        x[2], y[2], z[2]
-    };
+    updateInertiaCache();
+
+    // The rods start at rest (B = 0, moment 0)
+    addAxisRods(loop);
+    // Matrix R = attitude.toMatrix();
     // momentOfInertia = R * momentOfInertia * R.transpose();
 }
 
@@ -91,143 +72,228 @@ Satellite::Satellite(Matrix inMOI,
 // -- -- --- //
 
 
-void Satellite::setMomentOfInertia(Matrix MOI){
+template <typename Model>
+void BasicSatellite<Model>::setMomentOfInertia(Matrix MOI){
     momentOfInertia = MOI;
+    updateInertiaCache();
+}
+
+
+template <typename Model>
+void BasicSatellite<Model>::addAxisRods(const Loop& loop){
+    const Vector axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    const int counts[3] = {numXHyst, numYHyst, numZHyst};
+    for (int i = 0; i < 3; i++){
+        Rod rod;
+        rod.axis = axes[i];
+        rod.volume = hystVol;
+        rod.demagFactor = hystNd;
+        rod.loop = loop;
+        rod.count = counts[i];
+        hystRods.addRod(rod);
+    }
+}
+
+
+template <typename Model>
+void BasicSatellite<Model>::updateInertiaCache(){
+    inverseInertia = momentOfInertia.inverse();
+
+    // A tensor given in its principal frame reduces the torque to
+    // acceleration map to one multiply per component; any other (the
+    // main.cpp one has a product of inertia) takes the cached inverse
+    inertiaDiagonal = momentOfInertia.isDiagonal();
+    inverseInertiaDiagonal = {inverseInertia(0, 0),
+                              inverseInertia(1, 1),
+                              inverseInertia(2, 2)};
 }
 
 
-void Satellite::setOrientation(Vector X, Vector Y, Vector Z){
-    x = X;
-    y = Y;
-    z = Z;
+template <typename Model>
+void BasicSatellite<Model>::setOrientation(Vector X, Vector Y, Vector Z){
+    attitude = Quaternion::fromAxes(X, Y, Z);
 }
 
 
-void Satellite::setAngularVelocity(Vector omega){
+template <typename Model>
+void BasicSatellite<Model>::setAttitude(Quaternion q){
+    attitude = q.normalized();
+}
+
+
+template <typename Model>
+void BasicSatellite<Model>::setAngularVelocity(Vector omega){
     angularVelocity = omega;
 }
 
 
-void Satellite::setAngularAcceleration(Vector alpha){
+template <typename Model>
+void BasicSatellite<Model>::setAngularAcceleration(Vector alpha){
     angularAcceleration = alpha;
 }
 
 
-void Satellite::setBarM(double m){
+template <typename Model>
+void BasicSatellite<Model>::setBarM(double m){
     barM = m;
 }
 
 
-void Satellite::updateHystM(Vector H, double timestep){
-    double BX = hystX.calcMagField(timestep, H, x);
-    // cout << "Returned x mag_field" << endl; //debug
-    hystMX = numXHyst * hystVol * ((BX / mu_0) - H*x) / (1 - hystNd);
-    // cout << "Hyst_x updated" << endl; //debug
-    double BY = hystY.calcMagField(timestep, H, y);
-    // cout << "Returned y mag_field" << endl; //debug
-    hystMY = numYHyst * hystVol * ((BY / mu_0) - H*y) / (1 - hystNd);
-    // cout << "Hyst_y updated" << endl; //debug
-    double BZ = hystZ.calcMagField(timestep, H, z);
-    // cout << "Returned z mag_field" << endl; //debug
-    hystMZ = numZHyst * hystVol * ((BZ / mu_0) - H*z) / (1 - hystNd);
-    // cout << "Hyst_z updated" << endl; //debug
+template <typename Model>
+void BasicSatellite<Model>::updateHystM(Vector H, double timestep){
+    TRACE_CALL;
+
+    // All rods in one pass; the models move with H, not with time
+    (void)timestep;
+    hystRods.update(H, attitude.toAxes());
 }
 
 
-void Satellite::setNumXHyst(int h){
+template <typename Model>
+void BasicSatellite<Model>::setNumXHyst(int h){
     numXHyst = h;
+    hystRods.setCount(0, h);
 }
 
 
-void Satellite::setNumYHyst(int h){
+template <typename Model>
+void BasicSatellite<Model>::setNumYHyst(int h){
     numYHyst = h;
+    hystRods.setCount(1, h);
 }
 
 
-void Satellite::setNumZHyst(int h){
+template <typename Model>
+void BasicSatellite<Model>::setNumZHyst(int h){
     numZHyst = h;
+    hystRods.setCount(2, h);
+}
+
+template <typename Model>
+void BasicSatellite<Model>::setHystLoop(const Loop& loop){
+    // The x, y, z stacks; added rods keep their own loops
+    for (size_t i = 0; i < 3; i++)
+        hystRods.setLoop(i, loop);
+}
+
+template <typename Model>
+void BasicSatellite<Model>::setHystKernel(Flatley::Kernel kernel){
+    hystRods.setKernel(kernel);
+}
+
+template <typename Model>
+void BasicSatellite<Model>::setHystTolerance(double tolerance){
+    hystRods.setTolerance(tolerance);
 }
 
-void Satellite::setHystCurve(double hC,
-                              double bR,
-                              double bS,
-                              double q0,
-                              double p){
-    hystX.setParameters(hC, bR, bS, q0, p);
-    hystY.setParameters(hC, bR, bS, q0, p);
-    hystZ.setParameters(hC, bR, bS, q0, p);
+template <typename Model>
+size_t BasicSatellite<Model>::addHystRod(const Rod& rod){
+    return hystRods.addRod(rod);
 }
 
 // -- -- --- //
 // ACCESSORS //
 // -- -- --- //
 //
-Matrix Satellite::getMomentOfInertia() const{
+template <typename Model>
+Matrix BasicSatellite<Model>::getMomentOfInertia() const{
     return momentOfInertia;
 }
 
-vector<Vector> Satellite::getOrientation() const{
-    vector<Vector> orientation = {x, y, z};
-    return orientation;
+
+template <typename Model>
+Matrix BasicSatellite<Model>::getInverseMomentOfInertia() const{
+    return inverseInertia;
+}
+
+
+template <typename Model>
+bool BasicSatellite<Model>::isInertiaDiagonal() const{
+    return inertiaDiagonal;
+}
+
+template <typename Model>
+array<Vector, 3> BasicSatellite<Model>::getOrientation() const{
+    return attitude.toAxes();
 }
 
 
-Vector Satellite::getAngularVelocity() const{
+template <typename Model>
+Quaternion BasicSatellite<Model>::getAttitude() const{
+    return attitude;
+}
+
+
+template <typename Model>
+Vector BasicSatellite<Model>::getAngularVelocity() const{
     return angularVelocity;
 }
 
 
-Vector Satellite::getAngularAcceleration() const{
+template <typename Model>
+Vector BasicSatellite<Model>::getAngularAcceleration() const{
     return angularAcceleration;
 }
 
 
-Vector Satellite::getHystM() const{
-    return {hystMX, hystMY, hystMZ};
+template <typename Model>
+Vector BasicSatellite<Model>::getHystM() const{
+    return hystRods.moment();
 }
 
 
-double Satellite::getHystVol() const{
+template <typename Model>
+double BasicSatellite<Model>::getHystVol() const{
     return hystVol;
 }
 
 
-double Satellite::getHystNd() const{
+template <typename Model>
+double BasicSatellite<Model>::getHystNd() const{
     return hystNd;
 }
 
-Vector Satellite::getHystB() const{
-    return  hystX.getMagField() +
-            hystY.getMagField() +
-            hystZ.getMagField();
+template <typename Model>
+Vector BasicSatellite<Model>::getHystB() const{
+    return hystRods.field();
 }
 
 
-Vector Satellite::getNetM() const{
-    Vector netM = {0,0,0};
-    netM += x * hystMX;
-    netM += y * hystMY;
-    netM += z * hystMZ;
-    return netM;
+template <typename Model>
+Vector BasicSatellite<Model>::getNetM() const{
+    array<Vector, 3> axes = attitude.toAxes();
+    Vector m = hystRods.moment();
+    return axes[0] * m[0] + axes[1] * m[1] + axes[2] * m[2];
 }
 
 
-int Satellite::getNumXHyst() const{
+template <typename Model>
+int BasicSatellite<Model>::getNumXHyst() const{
     return numXHyst;
 }
 
 
-int Satellite::getNumYHyst() const{
+template <typename Model>
+int BasicSatellite<Model>::getNumYHyst() const{
     return numYHyst;
 }
 
 
-int Satellite::getNumZHyst() const{
+template <typename Model>
+int BasicSatellite<Model>::getNumZHyst() const{
     return numZHyst;
 }
 
 
-double Satellite::getBarM() const{
+template <typename Model>
+const typename BasicSatellite<Model>::RodBank&
+BasicSatellite<Model>::getHystRods() const{
+    return hystRods;
+}
+
+
+template <typename Model>
+double BasicSatellite<Model>::getBarM() const{
     return barM;
 }
 
@@ -237,59 +303,74 @@ double Satellite::getBarM() const{
 // -- -- -- - //
 
 
-string Satellite::displayMomentOfInertia() const{
+template <typename Model>
+string BasicSatellite<Model>::displayMomentOfInertia() const{
     return momentOfInertia.display();
 }
 
 
-string Satellite::displayOrientation() const{
+template <typename Model>
+string BasicSatellite<Model>::displayOrientation() const{
+    array<Vector, 3> axes = attitude.toAxes();
     ostringstream oss;
-    oss << x.display() << endl
-        << y.display() << endl
-        << z.display() << endl;
+    oss << axes[0].display() << endl
+        << axes[1].display() << endl
+        << axes[2].display() << endl;
     return oss.str();
 }
 
 
-string Satellite::displayAngularVelocity() const{
+template <typename Model>
+string BasicSatellite<Model>::displayAngularVelocity() const{
     return angularVelocity.display();
 }
 
 
-string Satellite::displayAngularAcceleration() const{
+template <typename Model>
+string BasicSatellite<Model>::displayAngularAcceleration() const{
     return angularAcceleration.display();
 }
 
 
 // Function to apply torque
 
-void Satellite::applyTorque(Vector torque, double time){
+template <typename Model>
+void BasicSatellite<Model>::applyTorque(Vector torque, double time){
+    TRACE_CALL;
+
     // d_0 = wt + (1/2)at^2
     // Vector dTheta = angularVelocity * time + 
         // angularAcceleration * (time * time / 2);
     Vector dTheta = angularVelocity * time;
 
-    // defining parameters to make rotation matrix
-    Vector axis = dTheta.direction();
-    double uX = axis[0], uY = axis[1], uZ = axis[2];
-    double angle = dTheta.magnitude();
-    double c = cos(angle);
-    double s = sin(angle);
-
-    // Defining rotation matrix
-    Matrix R = {
-        uX*uX*(1-c) + c,      uX*uY*(1-c) - uZ*s,  uX*uZ*(1-c) + uY*s,
-        uX*uY*(1-c) + uZ*s,  uY*uY*(1-c) + c,      uY*uZ*(1-c) - uX*s,
-        uX*uZ*(1-c) - uY*s,  uY*uZ*(1-c) + uX*s,  uZ*uZ*(1-c) + c
-    };
-
-    // Updating values (position to velocity to angular velocity)
-    // changing orientation
-    x = (R * x).direction();
-    y = (R * y).direction();
-    z = (R * z).direction();
+    // Rotating the attitude by dTheta (inertial frame) through the
+    // exponential map, then restoring the unit norm lost to round-off
+    attitude = (Quaternion::fromRotationVector(dTheta) * attitude)
+                   .normalized();
 
     angularVelocity += angularAcceleration * time;
     // momentOfInertia = R * momentOfInertia * R.transpose();
-    angularAcceleration = momentOfInertia.inverse() * torque;
+    angularAcceleration = angularAccelerationFor(torque);
+}
+
+
+template <typename Model>
+Vector BasicSatellite<Model>::angularAccelerationFor(
+    const Vector& torque) const{
+    if (inertiaDiagonal){
+        return {torque[0] * inverseInertiaDiagonal[0],
+                torque[1] * inverseInertiaDiagonal[1],
+                torque[2] * inverseInertiaDiagonal[2]};
+    }
+    return inverseInertia * torque;
 }
+
+
+// -- -- -- -- -- //
+// INSTANTIATIONS //
+// -- -- -- -- -- //
+
+
+template class BasicSatellite<FlatleyAtan>;
+template class BasicSatellite<FlatleyDifferential>;
+template class BasicSatellite<JilesAtherton>;
@@ -3,10 +3,12 @@
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include "Numerics.h"
 #include "Vector.h"
 #include "DateTime.h"
 #include "Satellite.h"
+#include "Debug.h"
 
 using namespace std;
 
@@ -46,14 +48,62 @@ string clearScreenString(){
 }
 
 SampleDataVector readMagFile( const string& filename){
-    SampleDataVector data(filename, "\"Time (UTCG)\"", "\"x (nT)\"",
-                          "\"y (nT)\"","\"z (nT)\"");
+    // Binary series files (see csv_to_bin) are mapped, not parsed
+    if (isBinarySeries(filename))
+        return SampleDataVector::mapBinary(filename) * 7.95e-4;
+
+    SampleDataVector data(filename, "\"Time (UTCG)\"",
+                          {"\"x (nT)\"", "\"y (nT)\"", "\"z (nT)\""});
     data = data * 7.95e-4;
+    data.buildInterpolant();
+    return data;
+}
+
+SampleDataVector readMagFile(const string& filename,
+                             const DateTime& startTime,
+                             const DateTime& stopTime){
+    SampleDataVector data = SampleDataVector::openWindow(
+        filename, "\"Time (UTCG)\"",
+        {"\"x (nT)\"", "\"y (nT)\"", "\"z (nT)\""}, startTime, stopTime
+    ) * 7.95e-4;
+
+    // Per window only; a mapped file stays zero-copy
+    if (data.isWindowed())
+        data.buildInterpolant();
     return data;
 }
 
-void exportParams(const Satellite& satellite,
-                   const string& outputfile
+SampleDataVector readMagFile(const string& filename,
+                             const DateTime& startTime,
+                             const DateTime& stopTime,
+                             double timestep,
+                             const string& cacheDirectory){
+    FieldCache cache(cacheDirectory);
+    return cache.field(filename, "\"Time (UTCG)\"", "\"x (nT)\"",
+                       "\"y (nT)\"", "\"z (nT)\"",
+                       startTime, stopTime, timestep) * 7.95e-4;
+}
+
+static GeomagneticField fieldModel(const string& coefficientFile){
+    if (coefficientFile.empty())
+        return GeomagneticField();
+    return GeomagneticField(coefficientFile);
+}
+
+OrbitField readOrbitField(const string& positionFile,
+                          const string& coefficientFile){
+    // nT to A/m, as for the field exports
+    return OrbitField(positionFile, fieldModel(coefficientFile)) * 7.95e-4;
+}
+
+OrbitField orbitField(const OrbitPropagator& orbit,
+                      const string& coefficientFile){
+    return OrbitField(orbit, fieldModel(coefficientFile)) * 7.95e-4;
+}
+
+template <typename Model>
+void exportParams(const BasicSatellite<Model>& satellite,
+                  const string& outputfile
 ){
     string satellite_info_filename = 
         outputfile.substr( 0, outputfile.find_last_of('.')
@@ -80,6 +130,7 @@ void exportParams(const Satellite& satellite,
     info_file << "\nMagnetic Moment Details:\n";
     info_file << "Bar Magnet Moment (bar_m): " << satellite.getBarM() << "\n";
     info_file << "Hysteresis Rods:\n";
+    info_file << "Model: " << Model::name << "\n";
     info_file << "Volume: " << satellite.getHystVol() << " m^3\n";
     info_file << "Demag. Factor: " << satellite.getHystNd() << "\n";
     info_file << "Number of Rods - X: " << satellite.getNumXHyst()
@@ -89,7 +140,8 @@ void exportParams(const Satellite& satellite,
     info_file.close();
 }
 
-void printParams(const Satellite& satellite, ostream& ostring)
+template <typename Model>
+void printParams(const BasicSatellite<Model>& satellite, ostream& ostring)
 {
     ostring << fixed << setprecision(6);
     ostring << "Satellite Initial Configuration\n";
@@ -113,6 +165,7 @@ void printParams(const Satellite& satellite, ostream& ostring)
        << satellite.getBarM() << "\n";
 
     ostring << "Hysteresis Rods:\n";
+    ostring << "Model: " << Model::name << "\n";
     ostring << "Volume: "
        << satellite.getHystVol() << " m^3\n";
     ostring << "Demag. Factor: "
@@ -179,24 +232,71 @@ SimulationContext::SimulationContext(const DateTime& t)
           angularVelocity{0,0,0},
           angularAcceleration{0,0,0},
           hystMagField{0,0,0},
-          orientation{{0,0,0},{0,0,0},{0,0,0}}
+          orientation{}
     {}
 
-void advancePhysicsStep(Satellite& satellite,
-                        SampleDataVector& mag_data,
+// Field sources. An export is interpolated (cubic for the physics,
+// linear for the output as before); an orbit field is evaluated directly
+static Vector fieldAt(const SampleDataVector& mag_data,
+                      const DateTime& t, SampleCursor& at){
+    return mag_data.lagrangeInterpolate(t, at);
+}
+
+static Vector fieldAt(const OrbitField& mag_data,
+                      const DateTime& t, SampleCursor& at){
+    return mag_data.field(t, at);
+}
+
+static Vector outputField(const SampleDataVector& mag_data,
+                          const DateTime& t, SampleCursor& at){
+    return mag_data.linearInterpolate(t, at);
+}
+
+static Vector outputField(const OrbitField& mag_data,
+                          const DateTime& t, SampleCursor& at){
+    return mag_data.field(t, at);
+}
+
+// A model field outside its epoch's five years is extrapolated; an
+// export is taken as it is
+static void checkCoverage(const SampleDataVector&,
+                          const DateTime&, const DateTime&){}
+
+static void checkCoverage(const OrbitField& mag_data,
+                          const DateTime& startTime,
+                          const DateTime& stopTime){
+    const GeomagneticField& model = mag_data.model();
+    if (!model.covers(startTime) || !model.covers(stopTime))
+        cerr << "Warning: the field model (epoch "
+             << model.epoch().toString() << ") does not cover "
+             << startTime.toString() << " to " << stopTime.toString()
+             << "; its coefficients are extrapolated. Load a current"
+             << " IGRF table (see orbitField)." << endl;
+}
+
+// Torque on moment m in the field H
+static Vector magneticTorque(const Vector& m, const Vector& H){
+    return (m ^ H) * mu_0;
+}
+
+template <typename Model, typename Field>
+void advancePhysicsStep(BasicSatellite<Model>& satellite,
+                        const Field& mag_data,
                         SimulationContext& ctx,
                         double dt)
 {
+    TRACE_CALL;
+
     Vector xBody = ctx.orientation[0];
     Vector yBody = ctx.orientation[1];
     Vector zBody = ctx.orientation[2];
 
-    Vector H = mag_data.lagrangeInterpolate(ctx.time);
+    Vector H = fieldAt(mag_data, ctx.time, ctx.fieldCursor);
 
     satellite.updateHystM(H, dt);
     ctx.m = satellite.getHystM();
 
-    ctx.torque = (ctx.m ^ H) * mu_0;
+    ctx.torque = magneticTorque(ctx.m, H);
 
     ctx.trqBody = { ctx.torque * xBody,
                     ctx.torque * yBody,
@@ -212,56 +312,346 @@ void advancePhysicsStep(Satellite& satellite,
     ctx.hystMagField = satellite.getHystB();
 }
 
-void integrateEuler(Satellite& satellite,
-                    SampleDataVector& mag_data,
+template <typename Model, typename Field>
+void integrateEuler(BasicSatellite<Model>& satellite,
+                    const Field& mag_data,
                     SimulationContext& ctx,
                     double dt){
+    TRACE_CALL;
     advancePhysicsStep(satellite, mag_data, ctx, dt);
 }
 
-void integrateRK4(Satellite& satellite,
-                  SampleDataVector& mag_data,
+// -- -- -- -- -- -- -- -- //
+// STATE VECTOR INTEGRATION //
+// -- -- -- -- -- -- -- -- //
+
+// Rigid body state packed for the Runge-Kutta stages: attitude
+// quaternion (w, x, y, z) then angular velocity (inertial). The rods are
+// not part of it: their state moves with H rather than with time, so the
+// stages read it as it was at the start of the step (see
+// HysteresisRodBank::momentAt) and the step commits it once at its end.
+using AttitudeState = array<double, 7>;
+
+template <typename Model>
+static AttitudeState packState(const BasicSatellite<Model>& satellite){
+    Quaternion q = satellite.getAttitude();
+    Vector w = satellite.getAngularVelocity();
+    return {q.w, q.x, q.y, q.z, w[0], w[1], w[2]};
+}
+
+// y + h k
+static AttitudeState stageState(const AttitudeState& y, double h,
+                                const AttitudeState& k){
+    AttitudeState out;
+    for (size_t i = 0; i < out.size(); i++)
+        out[i] = y[i] + h * k[i];
+    return out;
+}
+
+// dy/dt at time t: dq/dt = (1/2) (0, w) q and dw/dt = I^-1 torque, with
+// the torque of the rods' moment in the field at t. Reads the satellite
+// and the field only (the cursor is a lookup hint)
+template <typename Model, typename Field>
+static AttitudeState attitudeDerivative(const BasicSatellite<Model>& satellite,
+                                        const Field& mag_data,
+                                        const DateTime& t,
+                                        const AttitudeState& y,
+                                        SampleCursor& at){
+    Quaternion q(y[0], y[1], y[2], y[3]);
+    Vector w = {y[4], y[5], y[6]};
+
+    Vector H = fieldAt(mag_data, t, at);
+    Vector m = satellite.getHystRods().momentAt(H,
+                                                q.normalized().toAxes());
+    Vector alpha = satellite.angularAccelerationFor(magneticTorque(m, H));
+
+    Quaternion dq = Quaternion(0, w[0], w[1], w[2]) * q;
+    return {0.5 * dq.w, 0.5 * dq.x, 0.5 * dq.y, 0.5 * dq.z,
+            alpha[0], alpha[1], alpha[2]};
+}
+
+// Sets the satellite to y at time t, moves the rods there and fills ctx
+// as advancePhysicsStep does
+template <typename Model, typename Field>
+static void commitState(BasicSatellite<Model>& satellite,
+                        const Field& mag_data,
+                        SimulationContext& ctx,
+                        const DateTime& t,
+                        const AttitudeState& y,
+                        double dt){
+    satellite.setAttitude(Quaternion(y[0], y[1], y[2], y[3]));
+    satellite.setAngularVelocity({y[4], y[5], y[6]});
+
+    Vector H = fieldAt(mag_data, t, ctx.fieldCursor);
+    satellite.updateHystM(H, dt);
+    ctx.m = satellite.getHystM();
+    ctx.torque = magneticTorque(ctx.m, H);
+    satellite.setAngularAcceleration(
+        satellite.angularAccelerationFor(ctx.torque));
+
+    ctx.orientation = satellite.getOrientation();
+    ctx.trqBody = { ctx.torque * ctx.orientation[0],
+                    ctx.torque * ctx.orientation[1],
+                    ctx.torque * ctx.orientation[2] };
+    ctx.angularVelocity = satellite.getAngularVelocity();
+    ctx.angularAcceleration = satellite.getAngularAcceleration();
+    ctx.hystMagField = satellite.getHystB();
+}
+
+// Classical fourth order Runge-Kutta over [ctx.time, ctx.time + dt],
+// each stage taking the field at its own time
+template <typename Model, typename Field>
+void integrateRK4(BasicSatellite<Model>& satellite,
+                  const Field& mag_data,
                   SimulationContext& ctx,
                   double dt){
-    Satellite s1 = satellite;
-    Satellite s2 = satellite;
-    Satellite s3 = satellite;
-    Satellite s4 = satellite;
-
-    SimulationContext c1 = ctx;
-    SimulationContext c2 = ctx;
-    SimulationContext c3 = ctx;
-    SimulationContext c4 = ctx;
-
-    advancePhysicsStep(s1, mag_data, c1, dt);
-    advancePhysicsStep(s2, mag_data, c2, dt * 0.5);
-    advancePhysicsStep(s3, mag_data, c3, dt * 0.5);
-    advancePhysicsStep(s4, mag_data, c4, dt);
-
-    satellite.setAngularVelocity(
-        (c1.angularVelocity +
-         c2.angularVelocity * 2.0 +
-         c3.angularVelocity * 2.0 +
-         c4.angularVelocity) / 6.0
-    );
-
-    satellite.setOrientation(
-        (c1.orientation[0] +
-         c2.orientation[0] * 2.0 +
-         c3.orientation[0] * 2.0 +
-         c4.orientation[0]) / 6.0,
-        (c1.orientation[1] +
-         c2.orientation[1] * 2.0 +
-         c3.orientation[1] * 2.0 +
-         c4.orientation[1]) / 6.0,
-        (c1.orientation[2] +
-         c2.orientation[2] * 2.0 +
-         c3.orientation[2] * 2.0 +
-         c4.orientation[2]) / 6.0
-    );
+    TRACE_CALL;
+
+    const DateTime t0 = ctx.time;
+    const DateTime tHalf = t0 + 0.5 * dt;
+    const DateTime t1 = t0 + dt;
+    SampleCursor& at = ctx.fieldCursor;
+
+    AttitudeState y = packState(satellite);
+    AttitudeState k1 = attitudeDerivative(satellite, mag_data, t0, y, at);
+    AttitudeState k2 = attitudeDerivative(satellite, mag_data, tHalf,
+                                          stageState(y, 0.5 * dt, k1), at);
+    AttitudeState k3 = attitudeDerivative(satellite, mag_data, tHalf,
+                                          stageState(y, 0.5 * dt, k2), at);
+    AttitudeState k4 = attitudeDerivative(satellite, mag_data, t1,
+                                          stageState(y, dt, k3), at);
+
+    for (size_t i = 0; i < y.size(); i++)
+        y[i] += dt / 6.0 * (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]);
+
+    commitState(satellite, mag_data, ctx, t1, y, dt);
+}
 
-    ctx.angularVelocity = satellite.getAngularVelocity();
-    ctx.orientation     = satellite.getOrientation();
+// Dormand-Prince 5(4): seven stages, the last at the fifth order
+// solution, so its derivative starts the next step
+namespace dormandPrince {
+    const double c[7] = {0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1, 1};
+    const double a[7][6] = {
+        {},
+        {1.0 / 5},
+        {3.0 / 40, 9.0 / 40},
+        {44.0 / 45, -56.0 / 15, 32.0 / 9},
+        {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729},
+        {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176,
+         -5103.0 / 18656},
+        {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784,
+         11.0 / 84}};
+
+    // Fifth less fourth order weights
+    const double e[7] = {71.0 / 57600, 0, -71.0 / 16695, 71.0 / 1920,
+                         -17253.0 / 339200, 22.0 / 525, -1.0 / 40};
+
+    // Continuous extension: weight i at theta of the step is
+    // sum_j dense[i][j] theta^(j+1), fourth order over the step
+    const double dense[7][4] = {
+        {1, -183.0 / 64, 37.0 / 12, -145.0 / 128},
+        {0, 0, 0, 0},
+        {0, 1500.0 / 371, -1000.0 / 159, 1000.0 / 371},
+        {0, -125.0 / 32, 125.0 / 12, -375.0 / 64},
+        {0, 9477.0 / 3392, -729.0 / 106, 25515.0 / 6784},
+        {0, -11.0 / 7, 11.0 / 3, -55.0 / 28},
+        {0, 3.0 / 2, -4, 5.0 / 2}};
+}
+
+using AttitudeStages = array<AttitudeState, 7>;
+
+// y + h sum_j a[j] k[j] over the first n stages
+static AttitudeState stageState(const AttitudeState& y, double h,
+                                const double* a, const AttitudeStages& k,
+                                size_t n){
+    AttitudeState out = y;
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < out.size(); i++)
+            out[i] += h * a[j] * k[j][i];
+    return out;
+}
+
+// One Dormand-Prince step of h from y at t0, k[0] holding dy/dt there.
+// Fills the other stages and returns the fifth order solution
+template <typename Model, typename Field>
+static AttitudeState dormandPrinceStep(const BasicSatellite<Model>& satellite,
+                                       const Field& mag_data,
+                                       const DateTime& t0,
+                                       const AttitudeState& y,
+                                       double h,
+                                       AttitudeStages& k,
+                                       SampleCursor& at){
+    using namespace dormandPrince;
+    for (size_t s = 1; s < k.size(); s++)
+        k[s] = attitudeDerivative(satellite, mag_data, t0 + c[s] * h,
+                                  stageState(y, h, a[s], k, s), at);
+    return stageState(y, h, a[6], k, 6);
+}
+
+// RMS of the step's error estimate, each component in units of
+// absTol + relTol |y|
+static double errorNorm(const AttitudeState& y0, const AttitudeState& y1,
+                        const AttitudeStages& k, double h,
+                        const StepControl& control){
+    double sum = 0;
+    for (size_t i = 0; i < y0.size(); i++){
+        double error = 0;
+        for (size_t s = 0; s < k.size(); s++)
+            error += dormandPrince::e[s] * k[s][i];
+        double scale = control.absTol
+                     + control.relTol * max(fabs(y0[i]), fabs(y1[i]));
+        double r = h * error / scale;
+        sum += r * r;
+    }
+    return sqrt(sum / y0.size());
+}
+
+// The state at theta (0..1) of the step of h from y0
+static AttitudeState denseState(const AttitudeState& y0,
+                                const AttitudeStages& k, double h,
+                                double theta){
+    double b[7];
+    for (size_t s = 0; s < k.size(); s++){
+        const double* d = dormandPrince::dense[s];
+        b[s] = theta * (d[0] + theta * (d[1] + theta * (d[2]
+                                                        + theta * d[3])));
+    }
+    return stageState(y0, h, b, k, k.size());
+}
+
+// Fills ctx for the state y at time t as commitState would, from the
+// rods as they are (nothing is committed)
+template <typename Model, typename Field>
+static void observeState(const BasicSatellite<Model>& satellite,
+                         const Field& mag_data,
+                         SimulationContext& ctx,
+                         const DateTime& t,
+                         const AttitudeState& y){
+    ctx.time = t;
+    ctx.orientation = Quaternion(y[0], y[1], y[2], y[3]).normalized()
+                          .toAxes();
+
+    Vector H = fieldAt(mag_data, t, ctx.fieldCursor);
+    ctx.m = satellite.getHystRods().momentAt(H, ctx.orientation);
+    ctx.torque = magneticTorque(ctx.m, H);
+    ctx.trqBody = { ctx.torque * ctx.orientation[0],
+                    ctx.torque * ctx.orientation[1],
+                    ctx.torque * ctx.orientation[2] };
+    ctx.angularVelocity = {y[4], y[5], y[6]};
+    ctx.angularAcceleration = satellite.angularAccelerationFor(ctx.torque);
+    ctx.hystMagField = satellite.getHystRods().fieldAt(H, ctx.orientation);
+}
+
+// A single Dormand-Prince step of dt, its fifth order solution kept
+// without error control
+template <typename Model, typename Field>
+void integrateDormandPrince(BasicSatellite<Model>& satellite,
+                            const Field& mag_data,
+                            SimulationContext& ctx,
+                            double dt){
+    TRACE_CALL;
+
+    AttitudeState y = packState(satellite);
+    AttitudeStages k;
+    k[0] = attitudeDerivative(satellite, mag_data, ctx.time, y,
+                              ctx.fieldCursor);
+    y = dormandPrinceStep(satellite, mag_data, ctx.time, y, dt, k,
+                          ctx.fieldCursor);
+    commitState(satellite, mag_data, ctx, ctx.time + dt, y, dt);
+}
+
+template <typename Model, typename Field>
+StepStatistics integrateAdaptive(
+    BasicSatellite<Model>& satellite,
+    const Field& mag_data,
+    SimulationContext& ctx,
+    const DateTime& stopTime,
+    double outputInterval,
+    const StepControl& control,
+    const function<void(const SimulationContext&)>& output){
+    TRACE_CALL;
+
+    // Times as seconds from the start, exact in a double over any run
+    const DateTime t0 = ctx.time;
+    const double span = stopTime - t0;
+    SampleCursor& at = ctx.fieldCursor;
+
+    StepStatistics stats;
+    AttitudeState y = packState(satellite);
+    AttitudeStages k;
+    k[0] = attitudeDerivative(satellite, mag_data, t0, y, at);
+    stats.evaluations = 1;
+
+    double tau = 0;
+    double h = min(outputInterval, control.maxStep);
+    long row = 0;
+
+    // Rows before the first step, and within each kept step (from the
+    // rods as they were at its start, as its stages saw them)
+    auto writeRows = [&](double upTo, double stepStart, double step,
+                         const AttitudeState& from){
+        while (row * outputInterval < span && row * outputInterval <= upTo){
+            double tRow = row * outputInterval;
+            AttitudeState yRow = step > 0
+                ? denseState(from, k, step, (tRow - stepStart) / step)
+                : from;
+            observeState(satellite, mag_data, ctx, t0 + tRow, yRow);
+            output(ctx);
+            row++;
+        }
+    };
+    writeRows(0, 0, 0, y);
+
+    while (tau < span){
+        h = min(h, span - tau);
+        DateTime t = t0 + tau;
+        AttitudeState next = dormandPrinceStep(satellite, mag_data, t, y,
+                                               h, k, at);
+        stats.evaluations += 6;
+        double error = errorNorm(y, next, k, h, control);
+
+        // The usual controller for a fifth order solution: the step
+        // that would have given an error of 0.9^5 of the tolerance
+        double factor = error > 0 ? 0.9 * pow(error, -0.2) : 5.0;
+        if (error <= 1 || h <= control.minStep){
+            writeRows(tau + h, tau, h, y);
+
+            tau += h;
+            commitState(satellite, mag_data, ctx, t0 + tau, next, h);
+            y = packState(satellite);
+            k[0] = k[6];
+
+            stats.accepted++;
+            stats.smallest = stats.accepted == 1 ? h : min(stats.smallest, h);
+            stats.largest = max(stats.largest, h);
+            h *= min(5.0, max(0.2, factor));
+        } else {
+            stats.rejected++;
+            h *= max(0.2, factor);
+        }
+        h = min(control.maxStep, max(control.minStep, h));
+    }
+    ctx.time = t0 + tau;
+    return stats;
+}
+
+template <typename Model, typename Field>
+void integrateStep(BasicSatellite<Model>& satellite,
+                   const Field& mag_data,
+                   SimulationContext& ctx,
+                   double dt,
+                   IntegratorType integrator){
+    switch (integrator){
+    case IntegratorType::Euler:
+        integrateEuler(satellite, mag_data, ctx, dt);
+        break;
+    case IntegratorType::RungeKutta4:
+        integrateRK4(satellite, mag_data, ctx, dt);
+        break;
+    case IntegratorType::DormandPrince45:
+        integrateDormandPrince(satellite, mag_data, ctx, dt);
+        break;
+    }
 }
 
 double computeAdaptiveTimestep(const SimulationContext& ctx,
@@ -275,34 +665,123 @@ double computeAdaptiveTimestep(const SimulationContext& ctx,
     return dt;
 }
 
-void simulate(Satellite satellite,
-              SampleDataVector mag_data,
+// One row of the results file from ctx, with the (output) field H
+static void writeRow(ostream& fout, const SimulationContext& ctx,
+                     const Vector& H){
+    // Fixed inertial frame (folded at compile time)
+    static constexpr Vector x_inrt = {1,0,0},
+                            y_inrt = {0,1,0},
+                            z_inrt = {0,0,1};
+
+    // Getting Variable Values
+    const Vector& x_body = ctx.orientation[0];
+    const Vector& y_body = ctx.orientation[1];
+    const Vector& z_body = ctx.orientation[2];
+    const Vector& hyst_mag_field = ctx.hystMagField;
+    const Vector& angular_velocity = ctx.angularVelocity;
+    const Vector& angular_acceleration = ctx.angularAcceleration;
+    const Vector& torque = ctx.torque;
+    const Vector& m = ctx.m;
+
+    fout << ctx.time.display() << ","
+         << H*x_body << ","
+         << H*y_body << ","
+         << H*z_body << ","
+         << H.magnitude() << ","
+         << hyst_mag_field * x_body << ","
+         << hyst_mag_field * y_body << ","
+         << hyst_mag_field * z_body << ","
+         << hyst_mag_field.magnitude() << ","
+         << m * x_body << ","
+         << m * y_body << ","
+         << m * z_body << ","
+         << m[0] << ","
+         << m[1] << ","
+         << m[2] << ","
+         << m.magnitude() << ","
+         << torque * x_inrt << ","
+         << torque * y_inrt << ","
+         << torque * z_inrt << ","
+         << torque * x_body << ","
+         << torque * y_body << ","
+         << torque * z_body << ","
+         << angular_velocity[0] << ","
+         << angular_velocity[1] << ","
+         << angular_velocity[2] << ","
+         << angular_velocity.magnitude() << ","
+         << angular_velocity * x_body << ","
+         << angular_velocity * y_body << ","
+         << angular_velocity * z_body << ","
+         << angular_velocity.magnitude() << ","
+         << angular_acceleration[0] << ","
+         << angular_acceleration[1] << ","
+         << angular_acceleration[2] << ","
+         << angular_acceleration * x_body << ","
+         << angular_acceleration * y_body << ","
+         << angular_acceleration * z_body << ","
+         << angular_acceleration.magnitude() << endl;
+}
+
+// The same row on screen, with the run's progress
+static void printRow(const SimulationContext& ctx, const Vector& H,
+                     const DateTime& startTime, int duration){
+    const Vector& x_body = ctx.orientation[0];
+    const Vector& y_body = ctx.orientation[1];
+    const Vector& z_body = ctx.orientation[2];
+    const Vector& angular_velocity = ctx.angularVelocity;
+    const Vector& angular_acceleration = ctx.angularAcceleration;
+
+    // start printing from the 8th line
+    ostringstream buffer;
+    buffer << "\033[25;1H";
+
+    buffer << "Time                         : " << ctx.time.display() << endl
+           << "Auxiliary Magnetic Field     : " << H.display() << endl
+           << "                 Magnitude   : " << H.magnitude() << endl
+           << "Hysteresis Magnetic Field(T) : " << ctx.hystMagField.display() 
+                << endl
+           << "Torque - Inertial (Nm)       : " << ctx.torque.display() << endl
+           << "Torque - Body (Nm)           : " << ctx.trqBody.display() << endl
+           << "                 Magnitude   : "
+                << ctx.hystMagField.magnitude() << endl
+           << "Angular Acceleration (rad/s) : "
+                << angular_acceleration.display() << endl
+           << "                 Magnitude   : "
+                << angular_acceleration.magnitude() << endl
+           << "Angular Velocity (Body)      : " <<
+                Vector{angular_velocity * x_body, 
+                       angular_velocity * y_body, 
+                       angular_velocity * z_body}.display() << endl
+           << "Angular Acceleration (Body)  : " <<
+                Vector{angular_acceleration * x_body, 
+                       angular_acceleration * y_body, 
+                       angular_acceleration * z_body}.display() << endl;
+
+    // add progress bar and write to screen
+    int progress = ctx.time - startTime;
+    buffer << progressBar(progress, duration, "Simulating");
+    buffer << endl << endl;
+    cout << buffer.str();
+}
+
+template <typename Model, typename Field>
+void simulate(BasicSatellite<Model> satellite,
+              const Field& mag_data,
               DateTime startTime,
               DateTime stopTime,
               double baseTimestep,
               string filename,
               IntegratorType integrator,
-              bool adaptiveTimestep) {
-
-    // Defining Variables for writing
-    Vector m = {0,0,0},
-           x_inrt = {1,0,0},
-           y_inrt = {0,1,0},
-           z_inrt = {0,0,1},
-           x_body = {1,0,0},
-           y_body = {0,1,0},
-           z_body = {0,0,1},
-           torque = {0,0,0},
-           trq_bd = {0,0,0},
-           angular_velocity = {0,0,0},
-           angular_acceleration = {0,0,0},
-           hyst_mag_field = {0,0,0},
-           H = {0,0,0};
+              bool adaptiveTimestep,
+              const StepControl& control) {
+    TRACE_CALL;
 
-    double hyst_mag_x = 0.0,
-           hyst_mag_y = 0.0,
-           hyst_mag_z = 0.0,
-           hyst_mag_m = 0.0;
+    // DormandPrince45 sizes its own steps (baseTimestep is its row
+    // spacing), so computeAdaptiveTimestep has no say there
+    if (integrator == IntegratorType::DormandPrince45 && adaptiveTimestep)
+        throw invalid_argument("simulate: adaptiveTimestep does not apply"
+                               " to DormandPrince45 (see StepControl)");
+    checkCoverage(mag_data, startTime, stopTime);
 
     filename = filename.substr(0, filename.find_last_of('.'))
                + ".csv";
@@ -313,115 +792,69 @@ void simulate(Satellite satellite,
 
     int duration = stopTime - startTime;
 
+    // Rows on a fixed cadence whatever the steps
+    if (integrator == IntegratorType::DormandPrince45){
+        StepStatistics stats = integrateAdaptive(
+            satellite, mag_data, ctx, stopTime, baseTimestep, control,
+            [&](const SimulationContext& row){
+                SampleCursor at = row.fieldCursor;
+                Vector H = outputField(mag_data, row.time, at);
+                writeRow(fout, row, H);
+                printRow(row, H, startTime, duration);
+            });
+
+        cout << "Steps: " << stats.accepted << " kept, " << stats.rejected
+             << " rejected, " << stats.evaluations << " evaluations; "
+             << stats.smallest << " to " << stats.largest << " s" << endl;
+        return;
+    }
+
     while (ctx.time < stopTime)
     {
-        // go up 13 lines
-        // cout << "\033[13A\033[1G";
-
-        // start printing from the 8th line
-        cout << "\033[25;1H";
-
         double dt = baseTimestep;
         if (adaptiveTimestep) {
             dt = computeAdaptiveTimestep(ctx, 0.01, baseTimestep);
         }
 
-        if (integrator == IntegratorType::Euler){
-            integrateEuler(satellite, mag_data, ctx, dt);
-        } else {
-            integrateRK4(satellite, mag_data, ctx, dt);
-        }
+        integrateStep(satellite, mag_data, ctx, dt, integrator);
 
-        // ---- File output (UNCHANGED LOGIC) ----
+        Vector H = outputField(mag_data, ctx.time, ctx.fieldCursor);
+        writeRow(fout, ctx, H);
+        printRow(ctx, H, startTime, duration);
 
-        // Getting Variable Values
-        hyst_mag_field = satellite.getHystB();
-        x_body = ctx.orientation[0];
-        y_body = ctx.orientation[1];
-        z_body = ctx.orientation[2];
-        hyst_mag_x = hyst_mag_field * x_body;
-        hyst_mag_y = hyst_mag_field * y_body;
-        hyst_mag_z = hyst_mag_field * z_body;
-        hyst_mag_m = hyst_mag_field.magnitude();
-        angular_velocity = satellite.getAngularVelocity();
-        angular_acceleration = satellite.getAngularAcceleration();
-        torque = ctx.torque;
-        trq_bd = ctx.trqBody;
-        m = ctx.m;
-        H = mag_data.linearInterpolate(ctx.time);
-
-        // Writing to the file
-        fout << ctx.time.display() << ","
-             << H*x_body << ","
-             << H*y_body << ","
-             << H*z_body << ","
-             << H.magnitude() << ","
-             << hyst_mag_x << ","
-             << hyst_mag_y << ","
-             << hyst_mag_z << ","
-             << hyst_mag_m << ","
-             << m * x_body << ","
-             << m * y_body << ","
-             << m * z_body << ","
-             << m[0] << ","
-             << m[1] << ","
-             << m[2] << ","
-             << m.magnitude() << ","
-             << torque * x_inrt << ","
-             << torque * y_inrt << ","
-             << torque * z_inrt << ","
-             << torque * x_body << ","
-             << torque * y_body << ","
-             << torque * z_body << ","
-             << angular_velocity[0] << ","
-             << angular_velocity[1] << ","
-             << angular_velocity[2] << ","
-             << angular_velocity.magnitude() << ","
-             << angular_velocity * x_body << ","
-             << angular_velocity * y_body << ","
-             << angular_velocity * z_body << ","
-             << angular_velocity.magnitude() << ","
-             << angular_acceleration[0] << ","
-             << angular_acceleration[1] << ","
-             << angular_acceleration[2] << ","
-             << angular_acceleration * x_body << ","
-             << angular_acceleration * y_body << ","
-             << angular_acceleration * z_body << ","
-             << angular_acceleration.magnitude() << endl;
-
-        // ---- Screen output ----
-        ostringstream buffer;
-
-        buffer << "Time                         : " << ctx.time.display() << endl
-               << "Auxiliary Magnetic Field     : " << H.display() << endl
-               << "                 Magnitude   : " << H.magnitude() << endl
-               << "Hysteresis Magnetic Field(T) : " << hyst_mag_field.display() 
-                    << endl
-               << "Torque - Inertial (Nm)       : " << torque.display() << endl
-               << "Torque - Body (Nm)           : " << trq_bd.display() << endl
-               << "                 Magnitude   : " << hyst_mag_m << endl
-               << "Angular Acceleration (rad/s) : "
-                    << angular_acceleration.display() << endl
-               << "                 Magnitude   : "
-                    << angular_acceleration.magnitude() << endl
-               << "Angular Velocity (Body)      : " <<
-                    Vector{angular_velocity * x_body, 
-                           angular_velocity * y_body, 
-                           angular_velocity * z_body}.display() << endl
-               << "Angular Acceleration (Body)  : " <<
-                    Vector{angular_acceleration * x_body, 
-                           angular_acceleration * y_body, 
-                           angular_acceleration * z_body}.display() << endl;
-
-        // add progress bar and write to screen
-        int progress = ctx.time - startTime;
-        buffer << progressBar(progress, duration, "Simulating");
-        buffer << endl << endl;
-        cout << buffer.str();
         ctx.time = ctx.time + dt;
     }
 }
 
+// The models of HysteresisModel.h, each on both field sources
+#define INSTANTIATE_FOR_FIELD(Model, Field)                                \
+    template void advancePhysicsStep(BasicSatellite<Model>&, const Field&, \
+                                     SimulationContext&, double);          \
+    template void integrateStep(BasicSatellite<Model>&, const Field&,      \
+                                SimulationContext&, double,                \
+                                IntegratorType);                           \
+    template StepStatistics integrateAdaptive(                             \
+        BasicSatellite<Model>&, const Field&, SimulationContext&,          \
+        const DateTime&, double, const StepControl&,                       \
+        const function<void(const SimulationContext&)>&);                  \
+    template void simulate(BasicSatellite<Model>, const Field&,            \
+                           DateTime, DateTime, double, string,             \
+                           IntegratorType, bool, const StepControl&);
+
+#define INSTANTIATE_FOR_MODEL(Model)                                       \
+    template void exportParams(const BasicSatellite<Model>&,               \
+                               const string&);                             \
+    template void printParams(const BasicSatellite<Model>&, ostream&);     \
+    INSTANTIATE_FOR_FIELD(Model, SampleDataVector)                         \
+    INSTANTIATE_FOR_FIELD(Model, OrbitField)
+
+INSTANTIATE_FOR_MODEL(FlatleyAtan)
+INSTANTIATE_FOR_MODEL(FlatleyDifferential)
+INSTANTIATE_FOR_MODEL(JilesAtherton)
+
+#undef INSTANTIATE_FOR_MODEL
+#undef INSTANTIATE_FOR_FIELD
+
 /*
 void simulate(Satellite satellite,
               SampleDataVector mag_data,
@@ -1,48 +1,25 @@
 #include "Debug.h"
-#include <vector>
 #include <string>
 #include <sstream>
-#include <mutex>
 
-namespace
-{
-    std::vector<std::string> call_stack;
-    std::mutex call_stack_mutex;
-}
+// NOTE: push/pop are inline in Debug.h; only the (cold) formatting of the
+// stack for an exception message lives here.
 
-void CallStackTracker::push(const std::string &func)
+std::string CallStackTracker::trace()
 {
-    std::lock_guard<std::mutex> lock(call_stack_mutex);
-    call_stack.push_back(func);
-}
+    std::ostringstream oss;
 
-void CallStackTracker::pop()
-{
-    std::lock_guard<std::mutex> lock(call_stack_mutex);
-    if (!call_stack.empty())
+    size_t first = 0;
+    if (stack.depth > capacity)
     {
-        call_stack.pop_back();
+        first = stack.depth - capacity;
+        oss << "... (" << first << " frames dropped) -> ";
     }
-}
 
-std::string CallStackTracker::trace()
-{
-    std::lock_guard<std::mutex> lock(call_stack_mutex);
-    std::ostringstream oss;
-    for (const auto &func : call_stack)
+    for (size_t i = first; i < stack.depth; ++i)
     {
-        oss << func << " -> ";
+        oss << stack.frames[i % capacity] << " -> ";
     }
     oss << "[EXCEPTION]";
     return oss.str();
 }
-
-CallTracer::CallTracer(const std::string &func)
-{
-    CallStackTracker::push(func);
-}
-
-CallTracer::~CallTracer()
-{
-    CallStackTracker::pop();
-}